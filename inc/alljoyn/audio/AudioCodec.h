@@ -38,6 +38,12 @@ namespace services {
  */
 const uint32_t FRAMES_PER_PACKET = 16384;
 
+/**
+ * The Connect parameter, for raw audio, giving the largest packet in
+ * frames that the source will send.
+ */
+#define MAX_FRAMES_PER_PACKET_PARAMETER "MaxFramesPerPacket"
+
 /**
  * The base class of audio decoders used by AudioSinkObject.
  */
@@ -135,6 +141,17 @@ class AudioEncoder {
      */
     virtual void GetConfiguration(Capability* configuration) = 0;
 
+    /**
+     * Sets the number of frames that will be passed to one call of
+     * Encode().  This must be called before Configure().
+     *
+     * @param[in] framesPerPacket the number of frames, at most
+     *                            FRAMES_PER_PACKET.
+     *
+     * @return true if the encoder supports the frame size.
+     */
+    virtual bool SetFrameSize(uint32_t framesPerPacket) { return false; }
+
     /**
      * Gets the maximum number of frames that can be passed to one call of
      * Encode().
@@ -75,6 +75,15 @@ class AudioDevice {
      */
     virtual bool Open(const char* format, uint32_t sampleRate, uint32_t numChannels, uint32_t& bufferSize) = 0;
 
+    /**
+     * Sets the buffer size to ask for on the next Open().  The device
+     * may not be able to honour it, Open() returns the size it got.
+     *
+     * @param[in] bufferSize the buffer size (in frames), or 0 for the
+     *                       device's default.
+     */
+    virtual void SetBufferTarget(uint32_t bufferSize) { }
+
     /**
      * Closes the audio device.
      *
@@ -29,6 +29,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+namespace qcc { class Event; }
+
 namespace ajn {
 namespace services {
 
@@ -37,6 +39,11 @@ namespace services {
  */
 class DataSource {
   public:
+    /**
+     * The input size of a data source without an end, such as live input.
+     */
+    static const uint64_t UNBOUNDED_INPUT_SIZE = 0xFFFFFFFFFFFFFFFFULL;
+
     virtual ~DataSource() { }
 
     /**
@@ -59,6 +66,14 @@ class DataSource {
      * @return the size of the data source in bytes.
      */
     virtual uint32_t GetInputSize() = 0;
+    /**
+     * @return the size of the data source in bytes, or
+     *         UNBOUNDED_INPUT_SIZE if it has no end.
+     *
+     * @remark Sources larger than 4GB or without an end override this.
+     * The default implementation returns GetInputSize().
+     */
+    virtual uint64_t GetInputSize64();
 
     /**
      * Reads data from the source.
@@ -72,11 +87,77 @@ class DataSource {
      */
     virtual size_t ReadData(uint8_t* buffer, size_t offset, size_t length) = 0;
 
+    /**
+     * Reads data from the source at a 64-bit offset.
+     *
+     * @param[in] buffer the buffer to read data into.
+     * @param[in] offset the byte offset from the beginning of the
+     *                   data source to read from.
+     * @param[in] length the length of buffer.
+     *
+     * @return the number of bytes read.
+     *
+     * @remark Sources larger than 4GB or without an end override this.
+     * The default implementation calls ReadData.
+     */
+    virtual size_t ReadData64(uint8_t* buffer, uint64_t offset, size_t length);
+
+    /**
+     * Gets a read-only view of the data instead of copying it.
+     *
+     * @param[out] data set to the data at offset.
+     * @param[in] offset the byte offset from the beginning of the
+     *                   data source.
+     * @param[in] length the maximum number of bytes wanted.
+     *
+     * @return the number of bytes in the view, or 0 if the source does
+     *         not support views and ReadData must be used instead.
+     *
+     * @remark The view stays valid until the data source is closed.
+     * The default implementation does not support views.
+     */
+    virtual size_t GetDataView(const uint8_t** data, size_t offset, size_t length);
+
+    /**
+     * @return true if the data can be read from any offset, false if
+     *         only recent data can be read again.
+     *
+     * @remark The default implementation returns true.
+     */
+    virtual bool IsSeekable();
+
     /**
      * Used by thread that calls ReadData to ensure a data is ready for reading
      * @return true if data is ready to read
      */
     virtual bool IsDataReady() = 0;
+
+    /**
+     * Gets an event that is set while data is ready for reading, so that
+     * the thread that calls ReadData can wait on it alongside its other
+     * events instead of polling IsDataReady.
+     *
+     * Sources that are fed asynchronously (e.g. live input) should
+     * override this, and keep the event set exactly while IsDataReady
+     * returns true.
+     *
+     * @return the event, or NULL if the source cannot signal readiness.
+     *
+     * @remark The default implementation returns NULL.
+     */
+    virtual qcc::Event* GetDataReadyEvent();
+
+    /**
+     * Blocks the thread that calls ReadData until data is ready for reading.
+     *
+     * The default implementation waits on GetDataReadyEvent, or polls
+     * IsDataReady if the source cannot signal.
+     *
+     * @param[in] timeout the maximum time to wait in milliseconds.
+     *
+     * @return true if data is ready to read, false if the timeout expired
+     */
+    virtual bool WaitForDataReady(uint32_t timeout);
 };
 
 }
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * A data source that reads another one ahead on a background thread
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _PREFETCHDATASOURCE_H_
+#define _PREFETCHDATASOURCE_H_
+
+#ifndef __cplusplus
+#error Only include PrefetchDataSource.h in C++ code.
+#endif
+
+#include <alljoyn/audio/DataSource.h>
+
+namespace qcc { class Event; class Mutex; class Thread; }
+
+namespace ajn {
+namespace services {
+
+/**
+ * Reads another data source sequentially on a background thread into a
+ * ring buffer, and serves ReadData from the ring.
+ *
+ * This keeps a slow input, such as a file on a network mount or a
+ * pipe, from stalling the threads that read the data.  Data is only
+ * ever read from the wrapped source in order, apart from when a read
+ * lands outside the ring, as after a seek, which restarts the
+ * prefetch at that offset.
+ */
+class PrefetchDataSource : public DataSource {
+  public:
+    /**
+     * The constructor.
+     *
+     * @param[in] dataSource the data source to read ahead, which must
+     *                       outlive this one.
+     * @param[in] durationMs the audio in milliseconds to read ahead of
+     *                       the last read.  The ring holds twice as much,
+     *                       so that recent data can be read again.
+     */
+    PrefetchDataSource(DataSource* dataSource, uint32_t durationMs = 2000);
+    virtual ~PrefetchDataSource();
+
+    double GetSampleRate() { return mSampleRate; }
+    uint32_t GetBytesPerFrame() { return mBytesPerFrame; }
+    uint32_t GetChannelsPerFrame() { return mChannelsPerFrame; }
+    uint32_t GetBitsPerChannel() { return mBitsPerChannel; }
+    uint32_t GetInputSize();
+    uint64_t GetInputSize64();
+
+    size_t ReadData(uint8_t* buffer, size_t offset, size_t length);
+
+    /**
+     * Reads data from the ring, waiting for the prefetch to reach offset.
+     *
+     * The wait is bounded, and ends early if the calling thread or the
+     * prefetch thread is stopping.  Use IsDataReady() to avoid waiting.
+     *
+     * @return the number of bytes read, which may be short of length, or
+     *         0 if the data did not arrive in time.
+     */
+    size_t ReadData64(uint8_t* buffer, uint64_t offset, size_t length);
+    bool IsSeekable();
+
+    /**
+     * @return true if the data after the last read is in the ring.
+     */
+    bool IsDataReady();
+
+    /**
+     * @return an event that is set while IsDataReady() returns true.
+     */
+    qcc::Event* GetDataReadyEvent();
+
+    /**
+     * @return the number of reads served from the ring.
+     */
+    uint64_t GetHitCount();
+
+    /**
+     * @return the number of reads that waited for the wrapped data source.
+     */
+    uint64_t GetMissCount();
+
+  private:
+    static void* PrefetchThread(void* arg);
+    void Prefetch();
+    void Restart(uint64_t offset);
+    void UpdateDataReady();
+
+    DataSource* mDataSource;
+    double mSampleRate;
+    uint32_t mBytesPerFrame;
+    uint32_t mChannelsPerFrame;
+    uint32_t mBitsPerChannel;
+    uint8_t* mBuffer;
+    size_t mBufferSize;
+    size_t mAheadSize; /* How far the ring is filled past the last read */
+    qcc::Mutex* mMutex;
+    uint64_t mStart; /* The offset in the data source of the oldest byte in the ring */
+    uint64_t mEnd; /* The offset of the byte after the newest one */
+    uint64_t mReadOffset; /* The end of the furthest read */
+    uint32_t mGeneration; /* Changed by Restart, so that a read started before it is dropped */
+    bool mEndOfData;
+    uint64_t mHits;
+    uint64_t mMisses;
+    qcc::Event* mFilledEvent; /* Set when data is added to the ring */
+    qcc::Event* mSpaceEvent; /* Set when a read makes room for more data */
+    qcc::Event* mDataReadyEvent; /* Set while the data after the last read is in the ring */
+    qcc::Thread* mThread;
+};
+
+}
+}
+
+#endif //_PREFETCHDATASOURCE_H_
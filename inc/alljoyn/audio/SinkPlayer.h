@@ -31,8 +31,10 @@
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace qcc {
+class Event;
 class Mutex;
 class Thread;
 }
@@ -41,6 +43,21 @@ namespace ajn {
 namespace services {
 
 struct SinkInfo;
+struct SinkDescriptor;
+struct EmitTask;
+struct EmitWorker;
+struct ReadAheadWorker;
+struct GroupCall;
+struct DataSourceChange;
+struct MultipointGroup;
+struct GroupJoin;
+struct FlushCall;
+class MultipointPortListener;
+class PacketStream;
+class SinkCache;
+class SharedMutex;
+class TrackQueue;
+class WorkerPool;
 class SinkSessionListener;
 class SignallingObject;
 
@@ -59,6 +76,51 @@ struct PlayerState {
     } Type;
 };
 
+/**
+ * The latency profiles a sink can be connected with.
+ */
+struct LatencyProfile {
+    /**
+     * The latency profiles a sink can be connected with.
+     */
+    typedef enum {
+        NORMAL, /**< A FIFO of several seconds that rides out network hiccups. */
+        LOW /**< A FIFO and audio device buffer of tens of milliseconds for
+                 interactive use such as paging. */
+    } Type;
+};
+
+/**
+ * How far ahead Play() and Pause() schedule the sinks, and why.
+ */
+struct StartLead {
+    uint64_t lead; /**< The lead time in nanoseconds, the sum of worstRtt, fillTime and margin. */
+    uint64_t worstRtt; /**< The worst round trip time to an opened sink in nanoseconds. */
+    uint64_t fillTime; /**< The time to encode and emit the first packets of every opened sink in nanoseconds. */
+    uint64_t margin; /**< The safety margin in nanoseconds. */
+    uint64_t bufferTime; /**< For a data source without an end, the time in nanoseconds to wait for a FIFO's worth of data before playing, not part of lead. */
+    qcc::String worstSink; /**< The name of the sink with the worst round trip time. */
+    StartLead() : lead(0), worstRtt(0), fillTime(0), margin(0), bufferTime(0) { }
+};
+
+/**
+ * Counters describing how the stream to a sink is doing, accumulated
+ * since the sink was added.
+ */
+struct SinkStats {
+    uint64_t bytesEmitted; /**< Encoded bytes sent in Data signals. */
+    uint64_t packetsEmitted; /**< Data signals sent. */
+    uint64_t packetsSkipped; /**< Packets dropped because their timestamp had already passed. */
+    uint64_t fifoRefills; /**< Times the FIFO was topped up after the initial fill. */
+    uint32_t lastFifoPosition; /**< The FIFO fill in bytes at the last refill. */
+    uint32_t averageFifoPosition; /**< The average FIFO fill in bytes at a refill. */
+    uint64_t rtt; /**< The smoothed control round trip time in nanoseconds. */
+    int64_t clockOffset; /**< The adjustment in nanoseconds applied to the sink clock when it was opened. */
+    uint64_t encodeTime; /**< The average time in nanoseconds to read and encode a packet. */
+    SinkStats() : bytesEmitted(0), packetsEmitted(0), packetsSkipped(0), fifoRefills(0), lastFifoPosition(0),
+        averageFifoPosition(0), rtt(0), clockOffset(0), encodeTime(0) { }
+};
+
 /**
  * Base class for sink events.
  */
@@ -103,10 +165,32 @@ class SinkListener {
      * @param[in] volume the volume.
      */
     virtual void VolumeChanged(const char* name, int16_t volume) { };
+
+    /**
+     * Called about once a second while a sink is playing.
+     *
+     * @param[in] name the name of the sink.
+     * @param[in] stats a snapshot of the sink's statistics.
+     */
+    virtual void SinkStatsChanged(const char* name, const SinkStats& stats) { };
+
+    /**
+     * Called when the player will not read a data source again, because
+     * every sink has played past it or it was replaced by
+     * SetDataSource() or a change of format.
+     *
+     * @param[in] dataSource a data source given to SetDataSource() or
+     *                       SetNextDataSource(), which may now be deleted.
+     */
+    virtual void DataSourceFinished(DataSource* dataSource) { };
 };
 
 /**
  * The object that implements streaming of WAV files to an audio sink.
+ *
+ * Several players may share one bus, each playing its own data source
+ * to its own sinks (a zone).  The players in a process share the
+ * threads that control and emit to the sinks.
  */
 class SinkPlayer : public ajn::MessageReceiver {
     friend class SinkSessionListener;
@@ -118,7 +202,8 @@ class SinkPlayer : public ajn::MessageReceiver {
      * @param[in] bus the bus to use.
      *
      * @remark The supplied bus must not be deleted before this object
-     * is deleted.
+     * is deleted.  A sink can only be added to one player on the bus
+     * at a time.
      */
     SinkPlayer(ajn::BusAttachment* bus);
 
@@ -133,6 +218,30 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool SetDataSource(DataSource* dataSource);
 
+    /**
+     * Queues a data source to play after the current one without a gap.
+     *
+     * A data source with the same format as the current one continues
+     * the same timeline, and the start of it is read and encoded as soon
+     * as it is queued.  Any number of such data sources can be queued.
+     *
+     * A data source with a different format is played once the sinks have
+     * played out the queue, by reconnecting each sink with the new format
+     * over its existing session.  Nothing more can be queued until then.
+     *
+     * @param[in] dataSource the data source.
+     *
+     * @return true if the data source was queued, false if the queue
+     *         ends with a data source without an end.
+     *
+     * @remark SetDataSource() must have been called first.  Queued data
+     * sources must stay valid until SinkListener::DataSourceFinished() is
+     * called for them or the player is deleted.  A data source is kept for
+     * a few seconds after every sink has played past it, and seeking back
+     * before the oldest data source still kept moves to its start.
+     */
+    bool SetNextDataSource(DataSource* dataSource);
+
     /**
      * Sets the preferred format for streaming.
      *
@@ -146,6 +255,107 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool SetPreferredFormat(const char* format);
 
+    /**
+     * Sets the range of audio data carried by each raw packet.
+     *
+     * Raw packets start at 100ms (clamped to this range) and grow when a
+     * sink's FIFO runs low, or shrink back while it stays healthy.
+     * Packets are never made shorter than the round trip time to the sink.
+     * Other formats use a fixed packet size.  Sinks that do not implement
+     * the Latency interface predate variable packet sizes and are always
+     * sent packets of FRAMES_PER_PACKET frames.
+     *
+     * @param[in] minMs the shortest packet in milliseconds.
+     * @param[in] maxMs the longest packet in milliseconds.
+     *
+     * @return true if the range is valid.
+     *
+     * @remark This should be called before any sinks are added via
+     * AddSink().
+     */
+    bool SetPacketDuration(uint32_t minMs, uint32_t maxMs);
+
+    /**
+     * Sets the latency profile to request from sinks.
+     *
+     * The profile sets the sink FIFO depth, the point at which the sink
+     * asks for more data, its audio device buffer and the margin used by
+     * Play() and Pause() together.  Sinks that can't achieve the low
+     * latency profile fall back to the normal profile, see
+     * GetLatencyProfile().
+     *
+     * @param[in] profile the profile.
+     *
+     * @return true if profile is supported.
+     *
+     * @remark This should be called before any sinks are added via
+     * AddSink().
+     */
+    bool SetLatencyProfile(LatencyProfile::Type profile);
+
+    /**
+     * Gets the latency profile a sink achieved when it was opened.
+     *
+     * @param[in] name the name of the sink.
+     *
+     * @return the profile, or NORMAL if the sink is not known.
+     */
+    LatencyProfile::Type GetLatencyProfile(const char* name);
+
+    /**
+     * Sets whether audio is paced out to sinks rather than sent in bursts.
+     *
+     * Without pacing, each refill sends as much as the sink's FIFO has
+     * room for at once, and sinks that refill together collide on the
+     * network.  With pacing, a sink starts with a fast fill of up to
+     * fastFillMs of audio, after which each refill is sent at ratePercent
+     * of real time, starting at a different offset for each sink.  Sinks
+     * with the low latency profile are never paced.
+     *
+     * @param[in] enabled true to pace emission.
+     * @param[in] fastFillMs the audio in milliseconds sent at full speed
+     *                       when a sink starts.
+     * @param[in] ratePercent the paced rate as a percentage of real time,
+     *                        which must be above 100 for the FIFO to refill.
+     *
+     * @return true if the rate is valid.
+     *
+     * @remark This should be called before any sinks are added via
+     * AddSink().
+     */
+    bool SetPacing(bool enabled, uint32_t fastFillMs = 1000, uint32_t ratePercent = 150);
+
+    /**
+     * Sets whether sinks share a multipoint session for audio data.
+     *
+     * Sinks connected with the same format and packet size join one
+     * multipoint session hosted by the player, and each packet is
+     * signalled once on it rather than once per sink.  A packet is only
+     * signalled when every sink in the session has room for it, so the
+     * fullest sink holds back the others.  Sinks that don't implement
+     * the Multipoint interface or that use the low latency profile are
+     * sent their own packets.
+     *
+     * @param[in] enabled true to group sinks.
+     *
+     * @remark This should be called before any sinks are added via
+     * AddSink().
+     */
+    void SetMultipoint(bool enabled);
+
+    /**
+     * Sets how much audio is read and encoded ahead of the sinks.
+     *
+     * A thread keeps packets encoded up to durationMs ahead of the sink
+     * furthest ahead, so that a slow data source or encoder does not hold
+     * up sending to the sinks.  Memory use grows with durationMs.
+     *
+     * @param[in] durationMs the read ahead depth in milliseconds, 0 to
+     *                       read and encode only as packets are sent.
+     *                       Defaults to 500.
+     */
+    void SetReadAhead(uint32_t durationMs);
+
     /**
      * Adds a listener for sink add/remove events.
      *
@@ -175,6 +385,45 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool AddSink(const char* name, ajn::SessionPort port, const char* path);
 
+    /**
+     * Adds a sink to the streaming session.
+     *
+     * Sinks added with their About device ID and app ID are remembered
+     * by the player, and reopening them skips introspecting the sink and
+     * reading its capabilities.
+     *
+     * @param[in] name the name of the sink.
+     * @param[in] port the session port of the sink.
+     * @param[in] path the object path of the sink.
+     * @param[in] deviceId the About device ID of the sink.
+     * @param[in] appId the About app ID of the sink.
+     *
+     * @return true if the sink was accepted for asynchronous add.
+     *
+     * @see SinkSearcher::Service
+     * @see SetSinkCacheFile()
+     */
+    bool AddSink(const char* name, ajn::SessionPort port, const char* path, const char* deviceId, const char* appId);
+
+    /**
+     * Sets the file used to remember sinks across restarts.
+     *
+     * @param[in] fileName the file to use, or NULL to only remember
+     *                     sinks for the lifetime of the player.
+     *
+     * @return true if the file was loaded or does not exist yet.
+     *
+     * @remark A remembered sink is verified when it is opened and is
+     * discovered again if it has changed.  The file is written once the
+     * sinks being opened have opened, not after each one.
+     */
+    bool SetSinkCacheFile(const char* fileName);
+
+    /**
+     * Forgets all remembered sinks.
+     */
+    void ClearSinkCache();
+
     /**
      * Removes a sink from the streaming session.
      *
@@ -208,6 +457,16 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     size_t GetSinkCount();
 
+    /**
+     * Gets the streaming statistics of a sink.
+     *
+     * @param[in] name the name of the sink.
+     * @param[out] stats a snapshot of the sink's statistics.
+     *
+     * @return false if the sink has not been added.
+     */
+    bool GetSinkStats(const char* name, SinkStats& stats);
+
     /**
      * Opens the stream to the sink.
      *
@@ -224,6 +483,31 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool OpenAllSinks();
 
+    /**
+     * The result of an operation on each sink, keyed by the name of the sink.
+     */
+    typedef std::map<qcc::String, QStatus> SinkResults;
+
+    /**
+     * The result of opening the stream to each sink.
+     */
+    typedef SinkResults OpenSinkResults;
+
+    /**
+     * Opens the stream to all sinks that are part of the streaming
+     * session.  The sinks are opened concurrently.
+     *
+     * @param[in] timeout the maximum time to wait in milliseconds, or 0
+     *                    to wait until every sink has finished opening.
+     * @param[out] results if not NULL, receives the result for each
+     *                     sink. Sinks that did not finish before the
+     *                     timeout are reported as ER_TIMEOUT and may
+     *                     still open in the background.
+     *
+     * @return true if the stream to every sink was opened.
+     */
+    bool OpenAllSinks(uint32_t timeout, OpenSinkResults* results = NULL);
+
     /**
      * Closes the stream to the sink.
      *
@@ -247,6 +531,17 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool IsPlaying();
 
+    /**
+     * Gets the lead time the next Play() or Pause() will use.
+     *
+     * The lead is the worst round trip time measured to any opened sink,
+     * from clock synchronization and previous Play and Pause commands,
+     * plus a safety margin.
+     *
+     * @return the lead time and its components.
+     */
+    StartLead GetStartLead();
+
     /**
      * Starts playing.
      *
@@ -256,6 +551,21 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool Play();
 
+    /**
+     * Starts playing.
+     *
+     * The Play command is sent to every opened sink before waiting for
+     * any of the replies, so the sinks start together.
+     *
+     * @param[out] results if not NULL, receives the result of the Play
+     *                     command for each sink.
+     *
+     * @return true if every sink started playing.
+     *
+     * @remark SetDataSource() must be called before Play.
+     */
+    bool Play(SinkResults* results);
+
     /**
      * Pauses playback.
      *
@@ -267,16 +577,59 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool Pause();
 
+    /**
+     * Pauses playback.
+     *
+     * The Pause command is sent to every playing sink before waiting for
+     * any of the replies, so the sinks stop together at the same
+     * presentation time.
+     *
+     * @param[out] results if not NULL, receives the result of the Pause
+     *                     command for each sink.
+     *
+     * @return true if every sink paused.
+     *
+     * @see Play()
+     */
+    bool Pause(SinkResults* results);
+
+    /**
+     * Moves playback to a new position in the data source.
+     *
+     * The sinks stay connected.  If playing, the emitters are stopped, a
+     * timed Flush followed by Play is sent to every sink for the same
+     * instant, and emission restarts at once from the new position with
+     * a common timestamp just after that instant.  If paused, the next
+     * Play() starts from the new position.
+     *
+     * @param[in] positionNanos the position from the start of the first
+     *                          queued data source in nanoseconds.  Positions past the
+     *                          end seek to the end, and positions in data sources
+     *                          already released seek to the oldest one kept.
+     * @param[out] results if not NULL, receives the result of the Flush
+     *                     and Play commands for each sink, the first
+     *                     failure if either failed.
+     *
+     * @return true if every sink flushed, false if a queued data source
+     *         can only be read in order, such as live input.
+     *
+     * @remark SetDataSource() must have been called before Seek.
+     */
+    bool Seek(uint64_t positionNanos, SinkResults* results = NULL);
+
     /**
      * Gets the mute state of sinks.
      *
      * @param[in] name the name of a sink or NULL to get all sinks.
      * @param[out] mute true if mute, false if unmute.  If name is
      *                   NULL, true only if all sinks are mute.
+     * @param[in] refresh true to ask the sinks rather than use the
+     *                    state cached when they were opened and kept
+     *                    current by MuteChanged.
      *
      * @return true on success.
      */
-    bool GetMute(const char* name, bool& mute);
+    bool GetMute(const char* name, bool& mute, bool refresh = false);
 
     /**
      * Mutes or unmutes the output of sinks.
@@ -295,20 +648,25 @@ class SinkPlayer : public ajn::MessageReceiver {
      * @param[out] low the minimum volume.
      * @param[out] high the maximum volume.
      * @param[out] step the volume step.
+     * @param[in] refresh true to ask the sink rather than use the range
+     *                    cached when it was opened.
      *
      * @return true on success.
      */
-    bool GetVolumeRange(const char* name, int16_t& low, int16_t& high, int16_t& step);
+    bool GetVolumeRange(const char* name, int16_t& low, int16_t& high, int16_t& step, bool refresh = false);
 
     /**
      * Gets the volume of sinks.
      *
      * @param[in] name the name of a sink.
      * @param[out] volume the volume.
+     * @param[in] refresh true to ask the sink rather than use the
+     *                    volume cached when it was opened and kept
+     *                    current by VolumeChanged.
      *
      * @return true on success.
      */
-    bool GetVolume(const char* name, int16_t& volume);
+    bool GetVolume(const char* name, int16_t& volume, bool refresh = false);
 
     /**
      * Sets the volume of sinks.
@@ -320,46 +678,246 @@ class SinkPlayer : public ajn::MessageReceiver {
      */
     bool SetVolume(const char* name, int16_t volume);
 
-  private:
+    /**
+     * Receives the results of the asynchronous volume and mute calls.
+     *
+     * The callbacks are made from a worker thread and may call back
+     * into the player.
+     */
+    class VolumeCallback {
+      public:
+        virtual ~VolumeCallback() { }
+
+        /**
+         * Called when GetMuteAsync() completes.
+         *
+         * @param[in] name the name passed to GetMuteAsync().
+         * @param[in] mute true if mute.  If name is NULL, true only if
+         *                 all sinks that replied are mute.
+         * @param[in] results the result for each sink.
+         * @param[in] context the context passed to GetMuteAsync().
+         */
+        virtual void GetMuteDone(const char* name, bool mute, const SinkResults& results, void* context) { }
+
+        /**
+         * Called when SetMuteAsync() completes.
+         *
+         * @param[in] name the name passed to SetMuteAsync().
+         * @param[in] results the result for each sink.
+         * @param[in] context the context passed to SetMuteAsync().
+         */
+        virtual void SetMuteDone(const char* name, const SinkResults& results, void* context) { }
+
+        /**
+         * Called when GetVolumeAsync() completes.
+         *
+         * @param[in] name the name passed to GetVolumeAsync().
+         * @param[in] volume the volume, valid if results holds ER_OK.
+         * @param[in] results the result for the sink.
+         * @param[in] context the context passed to GetVolumeAsync().
+         */
+        virtual void GetVolumeDone(const char* name, int16_t volume, const SinkResults& results, void* context) { }
+
+        /**
+         * Called when SetVolumeAsync() completes.
+         *
+         * @param[in] name the name passed to SetVolumeAsync().
+         * @param[in] results the result for the sink.
+         * @param[in] context the context passed to SetVolumeAsync().
+         */
+        virtual void SetVolumeDone(const char* name, const SinkResults& results, void* context) { }
+    };
 
-    static void* AddSinkThread(void* arg);
-    static void* EmitAudioThread(void* arg);
+    /**
+     * Gets the mute state of sinks without waiting for the replies.
+     * The sinks are asked in parallel.
+     *
+     * @param[in] name the name of a sink or NULL to get all sinks.
+     * @param[in] callback called with the result, may be NULL.
+     * @param[in] context passed to the callback.
+     *
+     * @return false if there is no such sink.
+     */
+    bool GetMuteAsync(const char* name, VolumeCallback* callback, void* context = NULL);
+
+    /**
+     * Mutes or unmutes the output of sinks without waiting for the
+     * replies.  The sinks are set in parallel.
+     *
+     * @param[in] name the name of a sink or NULL to set all sinks.
+     * @param[in] mute true to mute, false to unmute.
+     * @param[in] callback called with the result, may be NULL.
+     * @param[in] context passed to the callback.
+     *
+     * @return false if there is no such sink.
+     */
+    bool SetMuteAsync(const char* name, bool mute, VolumeCallback* callback, void* context = NULL);
+
+    /**
+     * Gets the volume of a sink without waiting for the reply.
+     *
+     * @param[in] name the name of a sink.
+     * @param[in] callback called with the result, may be NULL.
+     * @param[in] context passed to the callback.
+     *
+     * @return false if there is no such sink.
+     */
+    bool GetVolumeAsync(const char* name, VolumeCallback* callback, void* context = NULL);
+
+    /**
+     * Sets the volume of a sink without waiting for the reply.
+     *
+     * @param[in] name the name of a sink.
+     * @param[in] volume the volume.
+     * @param[in] callback called with the result, may be NULL.
+     * @param[in] context passed to the callback.
+     *
+     * @return false if there is no such sink.
+     */
+    bool SetVolumeAsync(const char* name, int16_t volume, VolumeCallback* callback, void* context = NULL);
+
+  private:
+    struct VolumeState {
+        bool mute;
+        int16_t volume;
+        int16_t low;
+        int16_t high;
+        int16_t step;
+        qcc::String objectPath; /* The object whose VolumeChanged and MuteChanged signals update the state */
+    };
+    typedef std::map<ajn::SessionId, VolumeState> VolumeCache;
+
+    static void* AddSinkJob(void* arg);
+    static void* OpenSinkJob(void* arg);
 
     bool RemoveSink(const char* name, bool lost);
     bool RemoveSink(ajn::SessionId sessionId, bool lost);
-    static void* RemoveSinkThread(void* arg);
+    static void* RemoveSinkJob(void* arg);
+
+    void StartEmitting(SinkInfo* si);
+    void StopEmitting(SinkInfo* si);
+    void StopEmitting(const std::list<SinkInfo*>& sinks);
+    bool IsEmitting(SinkInfo* si);
+    static void* EmitAudioThread(void* arg);
+    static void* ReadAheadThread(void* arg);
+    bool EmitAudio(EmitTask* task);
+    void RestartFinishedEmitters();
+    void CheckEndOfQueue();
+    static void* ChangeDataSourceJob(void* arg);
+    void ChangeDataSource();
+    static void* ReconnectSinkJob(void* arg);
+    QStatus ReconnectSink(SinkInfo* si);
+    void ReconnectSinkDone(DataSourceChange* change, const qcc::String& name, QStatus status);
+    void AdaptPacketSize(EmitTask* task, uint32_t bytesRequested, bool skipped);
+    void StartPacing(EmitTask* task, uint32_t bytes, uint32_t inputPacketBytes, uint64_t delay);
+    uint32_t TakePacingTokens(EmitTask* task, uint32_t inputPacketBytes);
+    void SpendPacingTokens(EmitTask* task, uint32_t bytesEmitted, uint32_t inputPacketBytes);
+    void AssignGroup(SinkInfo* si);
+    bool JoinGroup(SinkInfo* si, bool& grouped);
+    void JoinReplyHandler(ajn::Message& msg, void* context);
+    void FinishJoin(GroupJoin* join, QStatus status, ajn::SessionId sessionId, const qcc::String& memberName);
+    void LeaveGroup(SinkInfo* si);
+    void FlushGroup(MultipointGroup* group);
+    void ResetGroups();
+    void GetSinkStats(SinkInfo* si, SinkStats& stats);
+    static void* SinkStatsJob(void* arg);
+    static void* ReleaseTracksJob(void* arg);
+    void ReleaseTracks();
+    void NotifyDataSourcesFinished(const std::vector<DataSource*>& dataSources);
+    static void* DataSourcesFinishedJob(void* arg);
+    uint32_t PacketDurationToFrames(uint32_t ms);
 
     void FlushReplyHandler(ajn::Message& msg, void* context);
+    static void* FlushDoneJob(void* arg);
+    void FlushDone(FlushCall* flush);
+    void CallSinkAsync(GroupCall* group, SinkInfo* si, const char* iface, const char* method, const ajn::MsgArg* args, size_t numArgs);
+    void GroupCallReplyHandler(ajn::Message& msg, void* context);
+    void UpdateRtts(GroupCall* group);
+    bool CallVolumeProperty(GroupCall* group, const char* name, const char* property, const ajn::MsgArg* value);
+    bool QueueVolumeCall(const char* name, const char* property, const ajn::MsgArg* value, VolumeCallback* callback, void* context);
+    void FinishVolumeCall(GroupCall* group);
+    void DeleteVolumeCall(GroupCall* group);
+    static void* VolumeCallDoneJob(void* arg);
+    void SeedVolumeCache(SinkInfo* si);
+    bool GetCachedVolume(const char* name, VolumeState& state);
+    void CacheVolumeResults(GroupCall* group, const char* property, const ajn::MsgArg* value);
+    void CacheVolumeValue(ajn::SessionId sessionId, const char* property, const ajn::MsgArg& value, const char* objectPath = NULL);
+    StartLead ComputeStartLead();
     void MuteChangedSignalHandler(const ajn::InterfaceDescription::Member* member, const char* sourcePath, ajn::Message& msg);
     void VolumeChangedSignalHandler(const ajn::InterfaceDescription::Member* member, const char* sourcePath, ajn::Message& msg);
 
+    QStatus OpenSink(SinkInfo* si);
+    bool LoadSinkDescriptor(SinkInfo* si, SinkDescriptor& descriptor);
+    QStatus DiscoverSink(SinkInfo* si, SinkDescriptor& descriptor);
+    QStatus ConnectSink(SinkInfo* si, SinkDescriptor& descriptor);
+    void ResetSinkFormat(SinkInfo* si);
     QStatus CloseSink(SinkInfo* si, bool lost = false);
+    SinkInfo* LookupSink(const char* name);
+    SinkInfo* LookupSink(ajn::SessionId sessionId);
     void FreeSinkInfo(SinkInfo* si);
 
+    PacketStream* AcquirePacketStream(const char* type, uint32_t framesPerPacket);
+    void ReleasePacketStream(PacketStream* ps);
+
     static void* SinkListenerThread(void* arg);
 
   private:
     typedef std::set<SinkListener*> SinkListeners;
-    typedef std::map<qcc::String, qcc::Thread*> ThreadMap;
-
+    typedef std::set<qcc::String> NameSet;
+    typedef std::map<qcc::String, SinkInfo*> SinkNameIndex;
+    typedef std::map<ajn::SessionId, SinkInfo*> SinkSessionIndex;
+    typedef std::pair<qcc::String, uint32_t> PacketStreamKey;
+    typedef std::map<PacketStreamKey, PacketStream*> PacketStreamMap;
+    typedef std::map<PacketStream*, MultipointGroup*> MultipointGroupMap;
+
+    uint32_t mZone; /* Distinguishes the signalling objects of the players on the bus */
     SignallingObject* mSignallingObject;
     qcc::Mutex* mSinkListenersMutex;
     SinkSessionListener* mSessionListener;
     ajn::BusAttachment* mMsgBus;
     char* mPreferredFormat;
+    LatencyProfile::Type mLatencyProfile;
+    uint32_t mMinPacketDuration;
+    uint32_t mMaxPacketDuration;
+    bool mPacing;
+    uint32_t mFastFillDuration;
+    uint32_t mPacingRate; /* Percent of real time */
+    bool mMultipoint;
+    uint32_t mReadAheadDuration; /* ms */
     char* mCurrentFormat;
     DataSource* mDataSource;
+    TrackQueue* mTrackQueue;
+    qcc::Mutex* mNextDataSourceMutex;
+    DataSource* mNextDataSource; /* Queued with a different format */
+    bool mChangingDataSource;
     ajn::MsgArg mChannelsArg;
     ajn::MsgArg mRateArg;
     ajn::MsgArg mFormatArg;
-    qcc::Mutex* mSinksMutex;
+    SharedMutex* mSinksMutex; /* Shared by lookups, exclusive for changes to the sinks */
     std::list<SinkInfo> mSinks;
-    qcc::Mutex* mAddThreadsMutex;
-    ThreadMap mAddThreads;
-    qcc::Mutex* mRemoveThreadsMutex;
-    ThreadMap mRemoveThreads;
-    qcc::Mutex* mEmitThreadsMutex;
-    ThreadMap mEmitThreads;
+    SinkNameIndex mSinksByName;
+    SinkSessionIndex mSinksBySession;
+    qcc::Mutex* mPendingAddsMutex;
+    NameSet mPendingAdds;
+    qcc::Mutex* mPendingRemovesMutex;
+    NameSet mPendingRemoves;
+    qcc::Mutex* mPendingOpensMutex;
+    NameSet mPendingOpens;
+    WorkerPool* mControlPool;
+    SinkCache* mSinkCache;
+    qcc::Mutex* mEmitTasksMutex;
+    std::map<qcc::String, EmitTask*> mEmitTasks;
+    std::vector<EmitWorker*> mEmitWorkers;
+    ReadAheadWorker* mReadAheadWorker;
+    qcc::Mutex* mPacketStreamsMutex;
+    PacketStreamMap mPacketStreams;
+    qcc::Mutex* mVolumeCacheMutex;
+    VolumeCache mVolumeCache; /* The volume state of the opened sinks, by session */
+    size_t mPendingVolumeCalls; /* Async volume calls not yet finished, guarded by mVolumeCacheMutex */
+    qcc::Event* mVolumeCallsDoneEvent; /* Set when mPendingVolumeCalls drops to 0 */
+    qcc::Mutex* mGroupsMutex;
+    MultipointGroupMap mGroups; /* By the packet stream the members share */
+    MultipointPortListener* mMultipointPortListener;
     PlayerState::Type mState;
     SinkListeners mSinkListeners;
     std::list<ajn::Message> mSinkListenerQueue;
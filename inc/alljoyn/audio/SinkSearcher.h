@@ -78,6 +78,8 @@ class SinkSearcher : public ajn::BusListener, public ajn::MessageReceiver {
         qcc::String path; /**< The object path of the sink. */
         uint16_t port; /**< The session port of the sink. */
         qcc::String friendlyName; /**< The friendly name of the sink, suitable for display in the UI. */
+        qcc::String deviceId; /**< The About device ID of the sink. */
+        qcc::String appId; /**< The About app ID of the sink, in hex. */
         bool found; /**< True if the device is found, false if it is lost. */
         Service() : port(0), found(false) { }
     };
@@ -0,0 +1,109 @@
+/**
+ * @file
+ * The base class of data sources that are read in order, such as live input
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _STREAMINGDATASOURCE_H_
+#define _STREAMINGDATASOURCE_H_
+
+#ifndef __cplusplus
+#error Only include StreamingDataSource.h in C++ code.
+#endif
+
+#include <alljoyn/audio/DataSource.h>
+
+namespace qcc { class Mutex; }
+
+namespace ajn {
+namespace services {
+
+/**
+ * The base class of data sources that can only be read in order, such
+ * as live input or a network stream, and that may have no end.
+ *
+ * Subclasses implement ReadStream() and the format getters.  Data read
+ * from the stream is kept for a while, so that the player can read it
+ * again for sinks that fall behind or to resend audio flushed on pause.
+ * Offsets are 64-bit, so the stream may run for as long as it likes.
+ */
+class StreamingDataSource : public DataSource {
+  public:
+    /**
+     * The constructor.
+     *
+     * @param[in] historyMs the audio in milliseconds kept after it has
+     *                      been read from the stream.
+     */
+    StreamingDataSource(uint32_t historyMs = 10000);
+    virtual ~StreamingDataSource();
+
+    /**
+     * Reads the next data from the stream.
+     *
+     * @param[in] buffer the buffer to read data into.
+     * @param[in] length the length of buffer.
+     *
+     * @return the number of bytes read, or 0 at the end of the stream.
+     *
+     * @remark Calls are never concurrent.  A call may block until data
+     * arrives, IsDataReady() tells the player when it would not.
+     */
+    virtual size_t ReadStream(uint8_t* buffer, size_t length) = 0;
+
+    /**
+     * @return the size of the data source in bytes, capped at 4GB.
+     */
+    uint32_t GetInputSize();
+
+    /**
+     * @return UNBOUNDED_INPUT_SIZE.  Streams of a known length override
+     *         this.
+     */
+    virtual uint64_t GetInputSize64();
+
+    size_t ReadData(uint8_t* buffer, size_t offset, size_t length);
+
+    /**
+     * Reads data from the history, reading the stream on to offset +
+     * length first if needed.
+     *
+     * @return the number of bytes read, or 0 if offset is no longer kept.
+     */
+    size_t ReadData64(uint8_t* buffer, uint64_t offset, size_t length);
+
+    /**
+     * @return false, only recent data can be read again.
+     */
+    bool IsSeekable() { return false; }
+
+  private:
+    uint32_t mHistoryDuration; /* ms */
+    qcc::Mutex* mReadMutex; /* Held while reading the stream, taken before mMutex */
+    qcc::Mutex* mMutex; /* Guards the history, but is not held while reading the stream */
+    uint8_t* mBuffer; /* Allocated on the first read, once the format is known */
+    size_t mBufferSize;
+    uint64_t mStart; /* The offset of the oldest byte kept */
+    uint64_t mEnd; /* The offset of the byte after the newest one */
+    bool mEndOfStream;
+};
+
+}
+}
+
+#endif //_STREAMINGDATASOURCE_H_
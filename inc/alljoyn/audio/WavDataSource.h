@@ -45,6 +45,9 @@ class WavDataSource : public DataSource {
     /**
      * Opens the file used to read data from.
      *
+     * The file is memory mapped where supported, otherwise data is read
+     * from it on demand.
+     *
      * @param[in] inputFile the file pointer.
      *
      * @return true if open.
@@ -70,14 +73,23 @@ class WavDataSource : public DataSource {
     uint32_t GetInputSize() { return mInputSize; }
 
     size_t ReadData(uint8_t* buffer, size_t offset, size_t length);
+    size_t GetDataView(const uint8_t** data, size_t offset, size_t length);
+
+    /**
+     * @return true if the file is memory mapped.
+     */
+    bool IsMemoryMapped() { return mMappedData != NULL; }
 
     /**
      * Since we read ondemand from a file always return true that data is ready
      */
     bool IsDataReady() { return true; }
+    bool WaitForDataReady(uint32_t timeout) { return true; }
 
   private:
     bool ReadHeader();
+    void MapInput();
+    void UnmapInput();
 
     double mSampleRate;
     uint32_t mBytesPerFrame;
@@ -87,6 +99,8 @@ class WavDataSource : public DataSource {
     uint32_t mInputDataStart;
     qcc::Mutex* mInputFileMutex;
     FILE* mInputFile;
+    const uint8_t* mMappedData;
+    size_t mMappedSize;
 };
 
 }
@@ -53,6 +53,7 @@ class ALSADevice : public AudioDevice {
     ~ALSADevice();
 
     bool Open(const char* format, uint32_t sampleRate, uint32_t numChannels, uint32_t& bufferSize);
+    void SetBufferTarget(uint32_t bufferSize) { mBufferTarget = bufferSize; }
     void Close(bool drain = false);
     bool Pause();
     bool Play();
@@ -96,6 +97,7 @@ class ALSADevice : public AudioDevice {
     snd_mixer_elem_t* mAudioMixerElementMaster;
     snd_mixer_elem_t* mAudioMixerElementPCM;
     bool mHardwareCanPause;
+    uint32_t mBufferTarget;
     qcc::Thread* mAudioMixerThread;
     qcc::Mutex* mListenersMutex;
     Listeners mListeners;
@@ -14,13 +14,17 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 
+#define __STDC_FORMAT_MACROS
+
 #include <alljoyn/audio/Audio.h>
 #include <alljoyn/audio/SinkPlayer.h>
 #include <alljoyn/audio/SinkSearcher.h>
 #include <alljoyn/audio/WavDataSource.h>
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/version.h>
+#include <qcc/Mutex.h>
 #include <qcc/String.h>
+#include <inttypes.h>
 #include <list>
 #include <signal.h>
 
@@ -43,7 +47,7 @@ class MySinkSearcher : public SinkSearcher {
         const char* path = sink->path.c_str();
         printf("Found \"%s\" %s objectPath=%s, sessionPort=%d\n", sink->friendlyName.c_str(), name, path, sink->port);
         if (!g_sinkPlayer->HasSink(name)) {
-            g_sinkPlayer->AddSink(name, sink->port, path);
+            g_sinkPlayer->AddSink(name, sink->port, path, sink->deviceId.c_str(), sink->appId.c_str());
         }
     }
 
@@ -81,9 +85,45 @@ class MySinkListener : public SinkListener {
         printf("VolumeChanged: %s volume=%d\n", name, volume);
     }
 
+    void DataSourceFinished(DataSource* dataSource) {
+        /* Only the queued data sources are ours to delete */
+        queueMutex.Lock();
+        for (list<WavDataSource*>::iterator it = queue.begin(); it != queue.end(); ++it) {
+            if (*it == dataSource) {
+                queue.erase(it);
+                delete dataSource;
+                break;
+            }
+        }
+        queueMutex.Unlock();
+    }
+
+    Mutex queueMutex;
+    list<WavDataSource*> queue;
+
   public:
     list<String> sinks;
 
+    ~MySinkListener() {
+        for (list<WavDataSource*>::iterator it = queue.begin(); it != queue.end(); ++it) {
+            delete *it;
+        }
+    }
+
+    bool Queue(WavDataSource* dataSource) {
+        /* Added before SetNextDataSource so that a quick DataSourceFinished finds it */
+        queueMutex.Lock();
+        queue.push_back(dataSource);
+        queueMutex.Unlock();
+        if (g_sinkPlayer->SetNextDataSource(dataSource)) {
+            return true;
+        }
+        queueMutex.Lock();
+        queue.remove(dataSource);
+        queueMutex.Unlock();
+        return false;
+    }
+
     void SetVolume(uint8_t volume) {
         for (list<String>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
             int16_t low, high, step;
@@ -230,6 +270,11 @@ int main(int argc, char** argv, char** envArg) {
                     g_sinkPlayer->Pause();
                 }
 
+            } else if (sscanf(buf, "seek %d", &i) == 1) {
+                if (i < 0 || !g_sinkPlayer->Seek((uint64_t)i * 1000000000)) {
+                    fprintf(stderr, "Failed to seek to %d seconds\n", i);
+                }
+
             } else if (sscanf(buf, "volume %128s %d%%", name, &i) == 2) {
                 g_sinkPlayer->SetVolume(name, i);
             } else if (sscanf(buf, "volume %d%%", &i) == 1) {
@@ -267,13 +312,33 @@ int main(int argc, char** argv, char** envArg) {
             } else if (strcmp(buf, "open") == 0) {
                 g_sinkPlayer->OpenAllSinks();
 
+            } else if (sscanf(buf, "queue %128s", name) == 1) {
+                WavDataSource* next = new WavDataSource();
+                if (!next->Open(name) || !listener.Queue(next)) {
+                    fprintf(stderr, "Failed to queue data source (%s)\n", name);
+                    delete next;
+                    continue;
+                }
+
             } else if (strcmp(buf, "close") == 0) {
                 g_sinkPlayer->CloseAllSinks();
 
+            } else if (strcmp(buf, "stats") == 0) {
+                for (list<String>::iterator it = listener.sinks.begin(); it != listener.sinks.end(); ++it) {
+                    SinkStats stats;
+                    if (g_sinkPlayer->GetSinkStats(it->c_str(), stats)) {
+                        printf("%s: emitted %" PRIu64 " packets (%" PRIu64 " bytes), skipped %" PRIu64 ", refills %" PRIu64
+                               ", fifo %u (avg %u), rtt %" PRIu64 "us, clock offset %" PRId64 "us, encode %" PRIu64 "us\n",
+                               it->c_str(), stats.packetsEmitted, stats.bytesEmitted, stats.packetsSkipped, stats.fifoRefills,
+                               stats.lastFifoPosition, stats.averageFifoPosition, stats.rtt / 1000, stats.clockOffset / 1000,
+                               stats.encodeTime / 1000);
+                    }
+                }
+
             } else if (strcmp(buf, "quit") == 0 || strcmp(buf, "exit") == 0) {
                 break;
             } else {
-                printf("available commands: open, close, play, pause, volume, mute, quit\n");
+                printf("available commands: open, queue, close, play, pause, seek, volume, mute, stats, quit\n");
             }
         }
     }
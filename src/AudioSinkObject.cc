@@ -41,12 +41,18 @@ using namespace std;
 #define FIFO_SIZE_IN_SECONDS    5
 #define FIFO_LOW_THRESHOLD      (FIFO_SIZE_IN_SECONDS - 1) /* The low-water mark at which FifoPositionChanged signal will be emitted */
 
+/* The low latency profile, in milliseconds */
+#define LOW_LATENCY_FIFO_SIZE           100
+#define LOW_LATENCY_FIFO_LOW_THRESHOLD  60
+#define LOW_LATENCY_DEVICE_BUFFER       20
+#define LOW_LATENCY_MAX_DEVICE_BUFFER   40 /* Beyond this the profile is not achieved */
+
 namespace ajn {
 namespace services {
 
 AudioSinkObject::AudioSinkObject(BusAttachment* bus, const char* path, StreamObject* stream, AudioDevice* audioDevice) :
     PortObject(bus, path, stream),
-    mPlayState(PlayState::IDLE), mLateChunkCount(0),
+    mPlayState(PlayState::IDLE), mCreditFlowControl(false), mLatencyProfile(LATENCY_PROFILE_NORMAL), mMultipointSessionId(0), mLateChunkCount(0),
     mDecodeThread(NULL), mDecoder(NULL),
     mAudioOutputEvent(new Event()), mAudioOutputThread(NULL),
     mAudioDevice(audioDevice), mAudioDeviceBufferSize(0) {
@@ -60,6 +66,21 @@ AudioSinkObject::AudioSinkObject(BusAttachment* bus, const char* path, StreamObj
     assert(audioSinkIntf);
     AddInterface(*audioSinkIntf);
 
+    /* Add Port.AudioSink.FlowControl interface */
+    const InterfaceDescription* flowControlIntf = bus->GetInterface(AUDIO_SINK_FLOW_CONTROL_INTERFACE);
+    assert(flowControlIntf);
+    AddInterface(*flowControlIntf);
+
+    /* Add Port.AudioSink.Latency interface */
+    const InterfaceDescription* latencyIntf = bus->GetInterface(AUDIO_SINK_LATENCY_INTERFACE);
+    assert(latencyIntf);
+    AddInterface(*latencyIntf);
+
+    /* Add Port.AudioSink.Multipoint interface */
+    const InterfaceDescription* multipointIntf = bus->GetInterface(AUDIO_SINK_MULTIPOINT_INTERFACE);
+    assert(multipointIntf);
+    AddInterface(*multipointIntf);
+
     /* Add VolumeControl interface */
     const InterfaceDescription* volumeIntf = bus->GetInterface(VOLUME_INTERFACE);
     assert(volumeIntf);
@@ -72,6 +93,7 @@ AudioSinkObject::AudioSinkObject(BusAttachment* bus, const char* path, StreamObj
         { audioSinkIntf->GetMember("Flush"), static_cast<MessageReceiver::MethodHandler>(&AudioSinkObject::Flush) },
         { volumeIntf->GetMember("AdjustVolume"), static_cast<MessageReceiver::MethodHandler>(&AudioSinkObject::AdjustVolume) },
         { volumeIntf->GetMember("AdjustVolumePercent"), static_cast<MessageReceiver::MethodHandler>(&AudioSinkObject::AdjustVolumePercent) },
+        { multipointIntf->GetMember("Join"), static_cast<MessageReceiver::MethodHandler>(&AudioSinkObject::Join) },
     };
     QStatus status = AddMethodHandlers(methodEntries, sizeof(methodEntries) / sizeof(methodEntries[0]));
     if (status != ER_OK) {
@@ -95,6 +117,9 @@ AudioSinkObject::AudioSinkObject(BusAttachment* bus, const char* path, StreamObj
     mFifoPositionChangedMember = audioSinkIntf->GetMember("FifoPositionChanged");
     assert(mFifoPositionChangedMember);
 
+    mFifoLevelChangedMember = flowControlIntf->GetMember("FifoLevelChanged");
+    assert(mFifoLevelChangedMember);
+
     mVolumeChangedMember = volumeIntf->GetMember("VolumeChanged");
     assert(mVolumeChangedMember);
 
@@ -124,6 +149,7 @@ void AudioSinkObject::Cleanup(bool drain) {
     StopAudioOutputThread();
     StopDecodeThread();
     mAudioDevice->Close(drainAudioDevice);
+    LeaveMultipointSession();
 
     mAudioOutputEvent->ResetEvent();
 
@@ -134,6 +160,8 @@ void AudioSinkObject::Cleanup(bool drain) {
 
     ClearBuffer();
     SetPlayState(PlayState::IDLE);
+    mCreditFlowControl = false;
+    mLatencyProfile = LATENCY_PROFILE_NORMAL;
 
     PortObject::Cleanup(drain);
 }
@@ -161,6 +189,26 @@ QStatus AudioSinkObject::Get(const char* ifcName, const char* propName, MsgArg&
         } else {
             status = ER_BUS_NO_SUCH_PROPERTY;
         }
+    } else if (0 == strcmp(ifcName, AUDIO_SINK_FLOW_CONTROL_INTERFACE)) {
+        if (0 == strcmp(propName, "Version")) {
+            val.Set("q", INTERFACES_VERSION);
+        } else {
+            status = ER_BUS_NO_SUCH_PROPERTY;
+        }
+    } else if (0 == strcmp(ifcName, AUDIO_SINK_MULTIPOINT_INTERFACE)) {
+        if (0 == strcmp(propName, "Version")) {
+            val.Set("q", INTERFACES_VERSION);
+        } else {
+            status = ER_BUS_NO_SUCH_PROPERTY;
+        }
+    } else if (0 == strcmp(ifcName, AUDIO_SINK_LATENCY_INTERFACE)) {
+        if (0 == strcmp(propName, "Version")) {
+            val.Set("q", INTERFACES_VERSION);
+        } else if (0 == strcmp(propName, "LatencyProfile")) {
+            val.Set("s", mLatencyProfile);
+        } else {
+            status = ER_BUS_NO_SUCH_PROPERTY;
+        }
     } else if (0 == strcmp(ifcName, VOLUME_INTERFACE)) {
         if (0 == strcmp(propName, "Version")) {
             val.Set("q", INTERFACES_VERSION);
@@ -289,8 +337,11 @@ void AudioSinkObject::DoConnect(const InterfaceDescription::Member* member, Mess
 
     mBytesPerFrame = (bitsPerChannel >> 3) * mChannelsPerFrame;
     mBytesPerSecond = mSampleRate * mBytesPerFrame;
-    mMaxBufferSize = mBytesPerSecond * FIFO_SIZE_IN_SECONDS;
-    mFifoLowThreshold = mBytesPerSecond * FIFO_LOW_THRESHOLD;
+
+    /* Sources that don't send FlowControl get the legacy FifoPositionChanged signal */
+    MsgArg* flowControlArg = GetParameterValue(mConfiguration->parameters, mConfiguration->numParameters, FLOW_CONTROL_PARAMETER);
+    mCreditFlowControl = (flowControlArg != NULL && flowControlArg->typeId == ALLJOYN_STRING &&
+                          strcmp(flowControlArg->v_string.str, FLOW_CONTROL_CREDIT) == 0);
 
     delete mDecoder;
     mDecoder = AudioDecoder::Create(mConfiguration->type.c_str());
@@ -302,12 +353,34 @@ void AudioSinkObject::DoConnect(const InterfaceDescription::Member* member, Mess
         return;
     }
 
+    /* Sources that don't send LatencyProfile get the normal profile */
+    MsgArg* latencyProfileArg = GetParameterValue(mConfiguration->parameters, mConfiguration->numParameters, LATENCY_PROFILE_PARAMETER);
+    bool lowLatency = (latencyProfileArg != NULL && latencyProfileArg->typeId == ALLJOYN_STRING &&
+                       strcmp(latencyProfileArg->v_string.str, LATENCY_PROFILE_LOW) == 0);
+
+    mAudioDevice->SetBufferTarget(lowLatency ? (mSampleRate * LOW_LATENCY_DEVICE_BUFFER / 1000) : 0);
     if (!mAudioDevice->Open(format, mSampleRate, mChannelsPerFrame, mAudioDeviceBufferSize)) {
         QCC_LogError(ER_FAIL, ("Failed to open audio device"));
         REPLY(ER_FAIL);
         return;
     }
 
+    /* Fall back to the normal profile if the device can't keep its own buffer short */
+    if (lowLatency && mAudioDeviceBufferSize > (mSampleRate * LOW_LATENCY_MAX_DEVICE_BUFFER / 1000)) {
+        QCC_LogError(ER_WARNING, ("Audio device buffer of %u frames is too large for low latency", mAudioDeviceBufferSize));
+        lowLatency = false;
+    }
+
+    if (lowLatency) {
+        mLatencyProfile = LATENCY_PROFILE_LOW;
+        mMaxBufferSize = mBytesPerFrame * (mSampleRate * LOW_LATENCY_FIFO_SIZE / 1000);
+        mFifoLowThreshold = mBytesPerFrame * (mSampleRate * LOW_LATENCY_FIFO_LOW_THRESHOLD / 1000);
+    } else {
+        mLatencyProfile = LATENCY_PROFILE_NORMAL;
+        mMaxBufferSize = mBytesPerSecond * FIFO_SIZE_IN_SECONDS;
+        mFifoLowThreshold = mBytesPerSecond * FIFO_LOW_THRESHOLD;
+    }
+
     StartAudioOutputThread();
 
     StartDecodeThread();
@@ -390,6 +463,45 @@ void AudioSinkObject::Flush(const InterfaceDescription::Member* member, Message&
     }
 }
 
+void AudioSinkObject::Join(const InterfaceDescription::Member* member, Message& msg) {
+    GET_ARGS(1);
+
+    if (mConfiguration == NULL) {
+        QCC_LogError(ER_FAIL, ("Not configured, can't join a multipoint session"));
+        REPLY(ER_FAIL);
+        return;
+    }
+
+    /* Data signals from the source arrive on either session, so nothing else changes.  The session is left on Close */
+    bus->EnableConcurrentCallbacks();
+    LeaveMultipointSession();
+    SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, true, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+    SessionId sessionId = 0;
+    QStatus status = bus->JoinSession(msg->GetSender(), args[0].v_uint16, NULL, sessionId, opts);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("JoinSession to multipoint port %u failed", args[0].v_uint16));
+        REPLY(status);
+        return;
+    }
+    mMultipointSessionId = sessionId;
+    QCC_DbgHLPrintf(("Joined multipoint session %u", sessionId));
+
+    MsgArg outArg("u", sessionId);
+    status = MethodReply(msg, &outArg, 1);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Join reply failed"));
+    }
+}
+
+void AudioSinkObject::LeaveMultipointSession() {
+    if (mMultipointSessionId != 0) {
+        /* Called from the Join and Close handlers */
+        bus->EnableConcurrentCallbacks();
+        bus->LeaveSession(mMultipointSessionId);
+        mMultipointSessionId = 0;
+    }
+}
+
 void AudioSinkObject::AdjustVolume(const InterfaceDescription::Member* member, Message& msg) {
     if (!mAudioDevice->GetEnabled()) {
         MethodReply(msg, ER_FAIL);
@@ -508,6 +620,10 @@ QStatus AudioSinkObject::EmitMuteChangedSignal(bool mute) {
 }
 
 QStatus AudioSinkObject::EmitFifoPositionChangedSignal() {
+    if (mCreditFlowControl) {
+        return EmitFifoLevelChangedSignal();
+    }
+
     uint8_t flags = 0;
     QStatus status = Signal(NULL, mStream->GetSessionId(), *mFifoPositionChangedMember, NULL, 0, 0, flags);
     if (status != ER_OK) {
@@ -517,6 +633,25 @@ QStatus AudioSinkObject::EmitFifoPositionChangedSignal() {
     return status;
 }
 
+QStatus AudioSinkObject::EmitFifoLevelChangedSignal() {
+    mBufferMutex.Lock();
+    uint32_t fifoPosition = GetCombinedBufferSize();
+    mBufferMutex.Unlock();
+    uint32_t credit = (fifoPosition < mMaxBufferSize) ? (mMaxBufferSize - fifoPosition) : 0;
+
+    MsgArg args[2];
+    args[0].Set("u", fifoPosition);
+    args[1].Set("u", credit);
+
+    uint8_t flags = 0;
+    QStatus status = Signal(NULL, mStream->GetSessionId(), *mFifoLevelChangedMember, args, 2, 0, flags);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to emit FifoLevelChanged signal"));
+    }
+
+    return status;
+}
+
 QStatus AudioSinkObject::EmitVolumeControlEnabledChangedSignal()
 {
     MsgArg arg("b", mAudioDevice->GetEnabled());
@@ -743,8 +878,7 @@ ThreadReturn AudioSinkObject::AudioOutputThread(void* arg) {
         uint64_t delay = 0;
         uint32_t delayInFrames = apo->mAudioDevice->GetDelay();
         if (delayInFrames > 0) {
-            size_t delayInBytes = delayInFrames * apo->mBytesPerFrame;
-            delay = (uint64_t)(((double)delayInBytes / apo->mBytesPerSecond) * 1000000000);
+            delay = FramesToNanos(delayInFrames, apo->mSampleRate);
         }
 
         QCC_DbgHLPrintf(("Difference between requested and expected chunk time: %" PRId64 " nanos",
@@ -762,9 +896,11 @@ ThreadReturn AudioSinkObject::AudioOutputThread(void* arg) {
             free((void*)ts.data);
         } else if (ts.dataSize > sizeToRead) {
             memcpy(buffer, ts.data + ts.offset, sizeToRead);
+            /* Offset the chunk's own timestamp rather than accumulating rounded increments */
+            uint64_t chunkTimestamp = ts.timestamp - FramesToNanos(ts.offset / apo->mBytesPerFrame, apo->mSampleRate);
             ts.offset += sizeToRead;
             ts.dataSize -= sizeToRead;
-            ts.timestamp += (uint64_t)(((double)sizeToRead / apo->mBytesPerSecond) * 1000000000);
+            ts.timestamp = chunkTimestamp + FramesToNanos(ts.offset / apo->mBytesPerFrame, apo->mSampleRate);
             apo->mBuffers.push_front(ts);
             sizeRead = sizeToRead;
         }
@@ -891,7 +1027,19 @@ size_t AudioSinkObject::GetCombinedBufferSize() {
 }
 
 size_t AudioSinkObject::GetDecodeBufferSize() {
-    return mDecodeBuffers.size() * (mDecoder ? mDecoder->GetFrameSize() * mBytesPerFrame : 0);
+    if (mDecoder == NULL) {
+        return 0;
+    }
+
+    /* Raw packets vary in size, so count them exactly rather than assume full ones */
+    if (mConfiguration->type == MIMETYPE_AUDIO_RAW) {
+        size_t size = 0;
+        for (TimedSamplesList::iterator it = mDecodeBuffers.begin(); it != mDecodeBuffers.end(); ++it)
+            size += (*it).dataSize;
+        return size;
+    }
+
+    return mDecodeBuffers.size() * mDecoder->GetFrameSize() * mBytesPerFrame;
 }
 
 size_t AudioSinkObject::GetBufferSize() {
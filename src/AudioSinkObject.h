@@ -86,6 +86,7 @@ class AudioSinkObject : public PortObject, public AudioDeviceListener {
 
     QStatus EmitPlayStateChangedSignal(uint8_t oldState, uint8_t newState);
     QStatus EmitFifoPositionChangedSignal();
+    QStatus EmitFifoLevelChangedSignal();
     QStatus EmitVolumeChangedSignal(int16_t volume);
     QStatus EmitMuteChangedSignal(bool mute);
     QStatus EmitVolumeControlEnabledChangedSignal();
@@ -96,6 +97,9 @@ class AudioSinkObject : public PortObject, public AudioDeviceListener {
     void Flush(const ajn::InterfaceDescription::Member* member, ajn::Message& msg);
     void AdjustVolume(const ajn::InterfaceDescription::Member* member, ajn::Message& msg);
     void AdjustVolumePercent(const ajn::InterfaceDescription::Member* member, ajn::Message& msg);
+    void Join(const ajn::InterfaceDescription::Member* member, ajn::Message& msg);
+
+    void LeaveMultipointSession();
 
     void DoPause();
     static qcc::ThreadReturn PauseThread(void* arg);
@@ -124,6 +128,7 @@ class AudioSinkObject : public PortObject, public AudioDeviceListener {
   private:
     const ajn::InterfaceDescription::Member* mPlayStateChangedMember;
     const ajn::InterfaceDescription::Member* mFifoPositionChangedMember;
+    const ajn::InterfaceDescription::Member* mFifoLevelChangedMember;
     const ajn::InterfaceDescription::Member* mVolumeChangedMember;
     const ajn::InterfaceDescription::Member* mMuteChangedMember;
     const ajn::InterfaceDescription::Member* mEnabledChangedMember;
@@ -132,6 +137,9 @@ class AudioSinkObject : public PortObject, public AudioDeviceListener {
 
     size_t mMaxBufferSize;
     size_t mFifoLowThreshold;
+    bool mCreditFlowControl;
+    const char* mLatencyProfile;
+    ajn::SessionId mMultipointSessionId; /* The source's multipoint session, shared with other sinks */
     qcc::Mutex mBufferMutex;
     TimedSamplesList mBuffers;
     uint32_t mLateChunkCount;
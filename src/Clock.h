@@ -43,6 +43,70 @@ __inline__ void SleepNanos(uint64_t nanos) {
 }
 #endif /* CLOCK_REALTIME */
 
+/**
+ * Converts a number of frames to nanoseconds, rounding down.
+ */
+__inline__ uint64_t FramesToNanos(uint64_t frames, uint32_t sampleRate) {
+    return (frames / sampleRate) * 1000000000 + ((frames % sampleRate) * 1000000000) / sampleRate;
+}
+
+/**
+ * Converts nanoseconds to a number of frames, rounding down.
+ */
+__inline__ uint64_t NanosToFrames(uint64_t nanos, uint32_t sampleRate) {
+    return (nanos / 1000000000) * sampleRate + ((nanos % 1000000000) * sampleRate) / 1000000000;
+}
+
+/**
+ * The presentation time of a stream, tracked as a position in frames
+ * from a fixed epoch so that rounding never accumulates.
+ *
+ * Clocks that share an epoch produce identical timestamps for the same
+ * position, however they got there.
+ */
+class MediaClock {
+  public:
+    MediaClock() : mSampleRate(0), mEpoch(0), mPosition(0) { }
+
+    /**
+     * Sets the clock so that the frame at position is presented at time.
+     */
+    void Set(uint32_t sampleRate, uint64_t position, uint64_t time) {
+        mSampleRate = sampleRate;
+        mPosition = position;
+        /* May wrap, GetTime() wraps back */
+        mEpoch = time - FramesToNanos(position, sampleRate);
+    }
+
+    /**
+     * Moves to another position while keeping the epoch.
+     */
+    void SetPosition(uint64_t position) {
+        mPosition = position;
+    }
+
+    void Advance(uint64_t frames) {
+        mPosition += frames;
+    }
+
+    uint64_t GetPosition() const {
+        return mPosition;
+    }
+
+    /**
+     * @return the presentation time in nanoseconds of the frame at the
+     *         current position.
+     */
+    uint64_t GetTime() const {
+        return mEpoch + FramesToNanos(mPosition, mSampleRate);
+    }
+
+  private:
+    uint32_t mSampleRate;
+    uint64_t mEpoch;
+    uint64_t mPosition;
+};
+
 }
 }
 
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * Default implementations of the DataSource interface
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <alljoyn/audio/DataSource.h>
+
+#include "Clock.h"
+#include <qcc/Event.h>
+
+#define DATA_READY_POLL_INTERVAL 10 /* ms between checks of a source that cannot signal readiness */
+
+namespace ajn {
+namespace services {
+
+const uint64_t DataSource::UNBOUNDED_INPUT_SIZE;
+
+uint64_t DataSource::GetInputSize64() {
+    return GetInputSize();
+}
+
+size_t DataSource::ReadData64(uint8_t* buffer, uint64_t offset, size_t length) {
+    if ((size_t)offset != offset) {
+        return 0;
+    }
+    return ReadData(buffer, (size_t)offset, length);
+}
+
+qcc::Event* DataSource::GetDataReadyEvent() {
+    return NULL;
+}
+
+bool DataSource::WaitForDataReady(uint32_t timeout) {
+    qcc::Event* dataReadyEvent = GetDataReadyEvent();
+    uint64_t deadline = GetCurrentTimeNanos() + (uint64_t)timeout * 1000000;
+    while (!IsDataReady()) {
+        uint64_t now = GetCurrentTimeNanos();
+        if (now >= deadline) {
+            return false;
+        }
+        uint64_t interval = (deadline - now + 999999) / 1000000;
+        if (dataReadyEvent != NULL) {
+            /* Another reader may take the data before this one checks, so wait again until the timeout */
+            qcc::Event::Wait(*dataReadyEvent, (uint32_t)interval);
+        } else {
+            if (interval > DATA_READY_POLL_INTERVAL) {
+                interval = DATA_READY_POLL_INTERVAL;
+            }
+            SleepNanos(interval * 1000000);
+        }
+    }
+    return true;
+}
+
+size_t DataSource::GetDataView(const uint8_t** data, size_t offset, size_t length) {
+    *data = NULL;
+    return 0;
+}
+
+bool DataSource::IsSeekable() {
+    return true;
+}
+
+}
+}
@@ -0,0 +1,253 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <alljoyn/audio/PrefetchDataSource.h>
+
+#include <qcc/Debug.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <qcc/time.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define QCC_MODULE "ALLJOYN_AUDIO"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define PREFETCH_CHUNK_SIZE (64 * 1024) /* Bytes read from the wrapped data source at a time */
+#define PREFETCH_WAIT_INTERVAL 10 /* ms between checks of the ring while a read waits, and of a wrapped data source that cannot signal */
+#define PREFETCH_IDLE_INTERVAL 100 /* ms between checks for growth of the wrapped data source at its end */
+#define PREFETCH_READ_TIMEOUT 1000 /* ms a read waits for the prefetch before returning what the ring has */
+
+using namespace qcc;
+
+namespace ajn {
+namespace services {
+
+PrefetchDataSource::PrefetchDataSource(DataSource* dataSource, uint32_t durationMs) : DataSource(),
+    mDataSource(dataSource), mMutex(new qcc::Mutex()), mStart(0), mEnd(0), mReadOffset(0), mGeneration(0),
+    mEndOfData(false), mHits(0), mMisses(0), mFilledEvent(new qcc::Event()), mSpaceEvent(new qcc::Event()),
+    mDataReadyEvent(new qcc::Event()) {
+    mSampleRate = mDataSource->GetSampleRate();
+    mBytesPerFrame = mDataSource->GetBytesPerFrame();
+    mChannelsPerFrame = mDataSource->GetChannelsPerFrame();
+    mBitsPerChannel = mDataSource->GetBitsPerChannel();
+
+    /* Whole frames, and at least a chunk so that the prefetch does not crawl */
+    size_t frames = (size_t)((uint64_t)durationMs * mSampleRate / 1000);
+    mAheadSize = MAX(frames * mBytesPerFrame, (size_t)PREFETCH_CHUNK_SIZE);
+    mBufferSize = 2 * mAheadSize;
+    mBuffer = (uint8_t*)malloc(mBufferSize);
+
+    mThread = new qcc::Thread("Prefetch", &PrefetchThread);
+    mThread->Start(this);
+}
+
+PrefetchDataSource::~PrefetchDataSource() {
+    mThread->Stop();
+    mThread->Join();
+    delete mThread;
+
+    free(mBuffer);
+    delete mDataReadyEvent;
+    delete mSpaceEvent;
+    delete mFilledEvent;
+    delete mMutex;
+}
+
+uint32_t PrefetchDataSource::GetInputSize() {
+    return mDataSource->GetInputSize();
+}
+
+uint64_t PrefetchDataSource::GetInputSize64() {
+    return mDataSource->GetInputSize64();
+}
+
+bool PrefetchDataSource::IsSeekable() {
+    return mDataSource->IsSeekable();
+}
+
+void PrefetchDataSource::Restart(uint64_t offset) {
+    QCC_DbgHLPrintf(("Restarting prefetch at offset %" PRIu64, offset));
+    mGeneration++;
+    mStart = offset;
+    mEnd = offset;
+    mReadOffset = offset;
+    mEndOfData = false;
+    mSpaceEvent->SetEvent();
+    UpdateDataReady();
+}
+
+/* Called with mMutex held whenever the ring or the last read moves */
+void PrefetchDataSource::UpdateDataReady() {
+    if (mEnd > mReadOffset || mEndOfData) {
+        mDataReadyEvent->SetEvent();
+    } else {
+        mDataReadyEvent->ResetEvent();
+    }
+}
+
+size_t PrefetchDataSource::ReadData(uint8_t* buffer, size_t offset, size_t length) {
+    return ReadData64(buffer, offset, length);
+}
+
+size_t PrefetchDataSource::ReadData64(uint8_t* buffer, uint64_t offset, size_t length) {
+    mMutex->Lock();
+    bool hit = (offset >= mStart && offset < mEnd);
+    if (hit) {
+        mHits++;
+    } else {
+        mMisses++;
+    }
+
+    /* A stalled wrapped data source must not hold up the reader for good */
+    Thread* selfThread = Thread::GetThread();
+    uint64_t deadline = GetTimestamp64() + PREFETCH_READ_TIMEOUT;
+    while (!(offset >= mStart && offset < mEnd) && !(mEndOfData && offset >= mEnd)) {
+        if (selfThread->IsStopping() || mThread->IsStopping() || GetTimestamp64() >= deadline) {
+            QCC_LogError(ER_TIMEOUT, ("Prefetch did not reach offset %" PRIu64 " in time", offset));
+            break;
+        }
+        if (offset < mStart || offset > mEnd + mAheadSize) {
+            Restart(offset);
+        } else if (offset > mReadOffset) {
+            /* Let the prefetch run on to offset */
+            mReadOffset = offset;
+            mSpaceEvent->SetEvent();
+            UpdateDataReady();
+        }
+        mFilledEvent->ResetEvent();
+        mMutex->Unlock();
+        Event::Wait(*mFilledEvent, PREFETCH_WAIT_INTERVAL);
+        mMutex->Lock();
+    }
+
+    size_t numBytes = 0;
+    if (offset < mEnd) {
+        numBytes = (size_t)MIN((uint64_t)length, mEnd - offset);
+        size_t pos = (size_t)(offset % mBufferSize);
+        size_t first = MIN(numBytes, mBufferSize - pos);
+        memcpy(buffer, mBuffer + pos, first);
+        memcpy(buffer + first, mBuffer, numBytes - first);
+
+        if (offset + numBytes > mReadOffset) {
+            mReadOffset = offset + numBytes;
+            mSpaceEvent->SetEvent();
+            UpdateDataReady();
+        }
+    }
+    mMutex->Unlock();
+    return numBytes;
+}
+
+bool PrefetchDataSource::IsDataReady() {
+    mMutex->Lock();
+    bool ready = mEnd > mReadOffset || mEndOfData;
+    mMutex->Unlock();
+    return ready;
+}
+
+qcc::Event* PrefetchDataSource::GetDataReadyEvent() {
+    return mDataReadyEvent;
+}
+
+uint64_t PrefetchDataSource::GetHitCount() {
+    mMutex->Lock();
+    uint64_t hits = mHits;
+    mMutex->Unlock();
+    return hits;
+}
+
+uint64_t PrefetchDataSource::GetMissCount() {
+    mMutex->Lock();
+    uint64_t misses = mMisses;
+    mMutex->Unlock();
+    return misses;
+}
+
+ThreadReturn PrefetchDataSource::PrefetchThread(void* arg) {
+    PrefetchDataSource* pds = reinterpret_cast<PrefetchDataSource*>(arg);
+    pds->Prefetch();
+    return 0;
+}
+
+void PrefetchDataSource::Prefetch() {
+    Thread* selfThread = Thread::GetThread();
+
+    while (!selfThread->IsStopping()) {
+        uint64_t inputSize = mDataSource->GetInputSize64();
+
+        mMutex->Lock();
+        mSpaceEvent->ResetEvent();
+        if (mEndOfData && mEnd < inputSize) {
+            /* The wrapped data source has grown */
+            mEndOfData = false;
+            UpdateDataReady();
+        }
+        uint64_t offset = mEnd;
+        uint32_t generation = mGeneration;
+        size_t length = 0;
+        if (!mEndOfData && offset < mReadOffset + mAheadSize) {
+            length = (size_t)MIN((uint64_t)PREFETCH_CHUNK_SIZE, mReadOffset + mAheadSize - offset);
+            /* Stop at the end of the ring, the next chunk wraps around */
+            length = MIN(length, mBufferSize - (size_t)(offset % mBufferSize));
+            if (offset + length > mStart + mBufferSize) {
+                /* Drop the oldest data to make room, readers only copy from the ring under the lock */
+                mStart = offset + length - mBufferSize;
+            }
+        }
+        mMutex->Unlock();
+
+        Event* dataReadyEvent = mDataSource->GetDataReadyEvent();
+        if (length > 0 && dataReadyEvent == NULL && !mDataSource->WaitForDataReady(PREFETCH_WAIT_INTERVAL)) {
+            /* The wrapped data source cannot signal, so it is polled */
+            continue;
+        }
+        if (length == 0 || !mDataSource->IsDataReady()) {
+            std::vector<Event*> checkEvents;
+            std::vector<Event*> signaledEvents;
+            checkEvents.push_back(&selfThread->GetStopEvent());
+            checkEvents.push_back(mSpaceEvent);
+            if (length > 0) {
+                /* Woken by the wrapped data source, or by a read that restarts the prefetch */
+                checkEvents.push_back(dataReadyEvent);
+            }
+            Event::Wait(checkEvents, signaledEvents, (length == 0) ? PREFETCH_IDLE_INTERVAL : Event::WAIT_FOREVER);
+            continue;
+        }
+
+        /* Only this thread writes to the ring, and readers never copy past mEnd */
+        size_t numBytes = mDataSource->ReadData64(mBuffer + offset % mBufferSize, offset, length);
+
+        mMutex->Lock();
+        if (generation == mGeneration) {
+            mEnd += numBytes;
+            mEndOfData = (numBytes == 0);
+            mFilledEvent->SetEvent();
+            UpdateDataReady();
+        }
+        mMutex->Unlock();
+    }
+}
+
+}
+}
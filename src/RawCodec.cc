@@ -17,6 +17,7 @@
 #include "RawCodec.h"
 
 #include <qcc/Debug.h>
+#include <string.h>
 
 #define QCC_MODULE "ALLJOYN_AUDIO"
 
@@ -25,7 +26,7 @@ using namespace ajn;
 namespace ajn {
 namespace services {
 
-RawDecoder::RawDecoder() {
+RawDecoder::RawDecoder() : mFramesPerPacket(FRAMES_PER_PACKET) {
 }
 
 RawDecoder::~RawDecoder() {
@@ -47,6 +48,17 @@ void RawDecoder::GetCapability(Capability* capability) {
 }
 
 QStatus RawDecoder::Configure(Capability* capability) {
+    /* Older sources don't send the parameter and may send up to FRAMES_PER_PACKET */
+    for (size_t i = 0; i < capability->numParameters; i++) {
+        if (0 == strcmp(capability->parameters[i].v_dictEntry.key->v_string.str, MAX_FRAMES_PER_PACKET_PARAMETER)) {
+            MsgArg* arg = capability->parameters[i].v_dictEntry.val->v_variant.val;
+            if (arg->typeId != ALLJOYN_UINT32 || arg->v_uint32 == 0 || arg->v_uint32 > FRAMES_PER_PACKET) {
+                QCC_LogError(ER_INVALID_DATA, ("Configure bad " MAX_FRAMES_PER_PACKET_PARAMETER " param"));
+                return ER_INVALID_DATA;
+            }
+            mFramesPerPacket = arg->v_uint32;
+        }
+    }
     return ER_OK;
 }
 
@@ -54,7 +66,7 @@ void RawDecoder::Decode(uint8_t** buffer, uint32_t* numBytes) {
     /* Nothing to do */
 }
 
-RawEncoder::RawEncoder() {
+RawEncoder::RawEncoder() : mFramesPerPacket(FRAMES_PER_PACKET) {
 }
 
 RawEncoder::~RawEncoder() {
@@ -66,6 +78,14 @@ QStatus RawEncoder::Configure(DataSource* dataSource) {
     return ER_OK;
 }
 
+bool RawEncoder::SetFrameSize(uint32_t framesPerPacket) {
+    if (framesPerPacket == 0 || framesPerPacket > FRAMES_PER_PACKET) {
+        return false;
+    }
+    mFramesPerPacket = framesPerPacket;
+    return true;
+}
+
 void RawEncoder::GetConfiguration(Capability* configuration) {
     configuration->type = MIMETYPE_AUDIO_RAW;
     configuration->numParameters = 3;
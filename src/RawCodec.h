@@ -51,8 +51,11 @@ class RawDecoder : public AudioDecoder {
     static void GetCapability(Capability* capability);
 
     QStatus Configure(Capability* capability);
-    uint32_t GetFrameSize() const { return FRAMES_PER_PACKET; }
+    uint32_t GetFrameSize() const { return mFramesPerPacket; }
     void Decode(uint8_t** buffer, uint32_t* numBytes);
+
+  private:
+    uint32_t mFramesPerPacket;
 };
 
 /**
@@ -66,13 +69,15 @@ class RawEncoder : public AudioEncoder {
     ~RawEncoder();
 
     QStatus Configure(DataSource* dataSource);
-    uint32_t GetFrameSize() const { return FRAMES_PER_PACKET; }
+    bool SetFrameSize(uint32_t framesPerPacket);
+    uint32_t GetFrameSize() const { return mFramesPerPacket; }
     void GetConfiguration(Capability* configuration);
     void Encode(uint8_t** buffer, uint32_t* numBytes);
 
   private:
     uint32_t mChannelsPerFrame;
     double mSampleRate;
+    uint32_t mFramesPerPacket;
 };
 
 }
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "SharedMutex.h"
+
+#include <vector>
+
+using namespace qcc;
+
+namespace ajn {
+namespace services {
+
+SharedMutex::SharedMutex() : mWriter(NULL), mWriterDepth(0), mWritersWaiting(0) {
+}
+
+void SharedMutex::Lock() {
+    Thread* self = Thread::GetThread();
+    mMutex.Lock();
+    if (mWriter != self) {
+        mWritersWaiting++;
+        while (mWriter != NULL || !mReaders.empty()) {
+            Wait();
+        }
+        mWritersWaiting--;
+    }
+    mWriter = self;
+    mWriterDepth++;
+    mMutex.Unlock();
+}
+
+void SharedMutex::Unlock() {
+    mMutex.Lock();
+    if (--mWriterDepth == 0) {
+        mWriter = NULL;
+        WakeAll();
+    }
+    mMutex.Unlock();
+}
+
+void SharedMutex::LockShared() {
+    Thread* self = Thread::GetThread();
+    mMutex.Lock();
+    if (mWriter == self) {
+        /* Nested in the exclusive lock */
+        mWriterDepth++;
+    } else {
+        std::map<Thread*, size_t>::iterator it = mReaders.find(self);
+        if (it != mReaders.end()) {
+            /* Nested in the shared lock, waiting for a writer would deadlock */
+            it->second++;
+        } else {
+            while (mWriter != NULL || mWritersWaiting > 0) {
+                Wait();
+            }
+            mReaders[self] = 1;
+        }
+    }
+    mMutex.Unlock();
+}
+
+void SharedMutex::UnlockShared() {
+    Thread* self = Thread::GetThread();
+    mMutex.Lock();
+    if (mWriter == self) {
+        --mWriterDepth;
+    } else {
+        std::map<Thread*, size_t>::iterator it = mReaders.find(self);
+        if (--it->second == 0) {
+            mReaders.erase(it);
+            if (mReaders.empty()) {
+                WakeAll();
+            }
+        }
+    }
+    mMutex.Unlock();
+}
+
+void SharedMutex::Wait() {
+    /* Each waiter has its own event so that no wake up is lost to another waiter */
+    Event wake;
+    mWaiters.push_back(&wake);
+    mMutex.Unlock();
+
+    /* Not Event::Wait(Event&), which also returns when the thread is alerted */
+    std::vector<Event*> checkEvents;
+    std::vector<Event*> signaledEvents;
+    checkEvents.push_back(&wake);
+    Event::Wait(checkEvents, signaledEvents);
+
+    mMutex.Lock();
+    mWaiters.remove(&wake);
+}
+
+void SharedMutex::WakeAll() {
+    for (std::list<Event*>::iterator it = mWaiters.begin(); it != mWaiters.end(); ++it) {
+        (*it)->SetEvent();
+    }
+    mWaiters.clear();
+}
+
+}
+}
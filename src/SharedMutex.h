@@ -0,0 +1,83 @@
+/**
+ * @file
+ * A mutex that many readers can hold at once.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _SHAREDMUTEX_H
+#define _SHAREDMUTEX_H
+
+#ifndef __cplusplus
+#error Only include SharedMutex.h in C++ code.
+#endif
+
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <list>
+#include <map>
+
+namespace ajn {
+namespace services {
+
+/**
+ * A mutex that many readers can hold at once.
+ *
+ * Like qcc::Mutex, the exclusive lock is recursive, and the thread that
+ * holds it may also take the shared lock.  A thread that holds only the
+ * shared lock must not take the exclusive lock.
+ *
+ * Writers are preferred: once one is waiting, new readers wait behind
+ * it, so that a steady stream of readers cannot starve it.  A thread
+ * that already holds the shared lock may still take it again.
+ */
+class SharedMutex {
+  public:
+    SharedMutex();
+
+    /**
+     * Takes the lock exclusively, waiting for any readers to leave.
+     */
+    void Lock();
+
+    void Unlock();
+
+    /**
+     * Takes the lock shared, waiting for a writer that holds the lock
+     * or is waiting for it.
+     */
+    void LockShared();
+
+    void UnlockShared();
+
+  private:
+    void Wait();
+    void WakeAll();
+
+    qcc::Mutex mMutex;
+    qcc::Thread* mWriter;
+    size_t mWriterDepth;
+    size_t mWritersWaiting;
+    std::map<qcc::Thread*, size_t> mReaders; /* The shared lock depth of each reader */
+    std::list<qcc::Event*> mWaiters;
+};
+
+}
+}
+
+#endif /* _SHAREDMUTEX_H */
@@ -34,6 +34,9 @@ namespace services {
 #define CLOCK_INTERFACE             "org.alljoyn.Stream.Clock" /**< The clock interface name. */
 #define PORT_INTERFACE              "org.alljoyn.Stream.Port" /**< The stream port interface name. */
 #define AUDIO_SINK_INTERFACE        "org.alljoyn.Stream.Port.AudioSink" /**< The audioSink port interface name. */
+#define AUDIO_SINK_FLOW_CONTROL_INTERFACE "org.alljoyn.Stream.Port.AudioSink.FlowControl" /**< The audioSink flow control interface name. */
+#define AUDIO_SINK_LATENCY_INTERFACE "org.alljoyn.Stream.Port.AudioSink.Latency" /**< The audioSink latency interface name. */
+#define AUDIO_SINK_MULTIPOINT_INTERFACE "org.alljoyn.Stream.Port.AudioSink.Multipoint" /**< The audioSink multipoint interface name. */
 #define AUDIO_SOURCE_INTERFACE      "org.alljoyn.Stream.Port.AudioSource" /**< The audioSource port interface name. */
 #define IMAGE_SINK_INTERFACE        "org.alljoyn.Stream.Port.ImageSink" /**< The imageSink port interface name. */
 #define IMAGE_SOURCE_INTERFACE      "org.alljoyn.Stream.Port.ImageSource" /**< The imageSource port interface name. */
@@ -44,6 +47,13 @@ namespace services {
 #define DIRECTION_SOURCE    0 /**< The value of a source port's Direction property. */
 #define DIRECTION_SINK      1 /**< The vaule of a sink port's Direction property. */
 
+#define FLOW_CONTROL_PARAMETER  "FlowControl" /**< The Connect configuration parameter selecting the flow control mode. */
+#define FLOW_CONTROL_CREDIT     "credit" /**< The sink pushes its FIFO level and credit in FifoLevelChanged. */
+
+#define LATENCY_PROFILE_PARAMETER "LatencyProfile" /**< The Connect configuration parameter selecting the latency profile. */
+#define LATENCY_PROFILE_NORMAL  "normal" /**< A deep FIFO that rides out network hiccups. */
+#define LATENCY_PROFILE_LOW     "low" /**< A shallow FIFO and device buffer for interactive use. */
+
 /**
  * The state of an AudioSink port.
  */
@@ -166,6 +176,10 @@ struct PlayState {
 #define ANNOUNCE_MATCH_RULE "type='signal',interface='" ABOUT_INTERFACE "',member='Announce',sessionless='t'"
 /** The Announce key for the friendly name. */
 #define ANNOUNCE_DEVICE_NAME "DeviceName"
+/** The Announce key for the device ID. */
+#define ANNOUNCE_DEVICE_ID "DeviceId"
+/** The Announce key for the app ID. */
+#define ANNOUNCE_APP_ID "AppId"
 
 /** The audio interfaces XML. */
 #define INTERFACES_XML " \
@@ -207,6 +221,24 @@ struct PlayState {
     <arg name=\"count\" type=\"u\" direction=\"out\"/> \
   </method> \
 </interface> \
+<interface name=\"org.alljoyn.Stream.Port.AudioSink.FlowControl\"> \
+  <property name=\"Version\" type=\"q\" access=\"read\"/> \
+  <signal name=\"FifoLevelChanged\"> \
+    <arg name=\"position\" type=\"u\"/> \
+    <arg name=\"credit\" type=\"u\"/> \
+  </signal> \
+</interface> \
+<interface name=\"org.alljoyn.Stream.Port.AudioSink.Latency\"> \
+  <property name=\"Version\" type=\"q\" access=\"read\"/> \
+  <property name=\"LatencyProfile\" type=\"s\" access=\"read\"/> \
+</interface> \
+<interface name=\"org.alljoyn.Stream.Port.AudioSink.Multipoint\"> \
+  <property name=\"Version\" type=\"q\" access=\"read\"/> \
+  <method name=\"Join\"> \
+    <arg name=\"port\" type=\"q\" direction=\"in\"/> \
+    <arg name=\"sessionId\" type=\"u\" direction=\"out\"/> \
+  </method> \
+</interface> \
 <interface name=\"org.alljoyn.Stream.Port.AudioSource\"> \
   <property name=\"Version\" type=\"q\" access=\"read\"/> \
   <signal name=\"Data\"> \
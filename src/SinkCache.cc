@@ -0,0 +1,489 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "SinkCache.h"
+
+#include "Sink.h"
+#include <qcc/Debug.h>
+#include <qcc/StringUtil.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QCC_MODULE "ALLJOYN_AUDIO"
+
+/*
+ * The cache file is line based, one "<field> <value>" per line, with a
+ * "sink <key>" line starting each descriptor.  An "xml" line continues
+ * the introspection XML of the interface before it, a "parameter" line
+ * adds to the capability before it.
+ */
+#define SINK_CACHE_VERSION "2"
+#define SINK_CACHE_LINE_SIZE 1024
+#define SINK_CACHE_XML_CHUNK_SIZE 512 /* Escaped XML written per line */
+#define SINK_CACHE_PARAMETER_TYPES "ynqius" /* Parameters of these types, or arrays of them, are cached */
+
+using namespace qcc;
+
+namespace ajn {
+namespace services {
+
+/**
+ * Escapes the characters that separate the fields of the file.
+ */
+static String Escape(const String& str) {
+    String escaped;
+    for (size_t i = 0; i < str.size(); i++) {
+        char c = str[i];
+        if (c == '%' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            char hex[4];
+            snprintf(hex, sizeof(hex), "%%%02X", (unsigned char)c);
+            escaped += hex;
+        } else {
+            escaped.append(&c, 1);
+        }
+    }
+    return escaped;
+}
+
+static String Unescape(const String& str) {
+    String unescaped;
+    for (size_t i = 0; i < str.size(); i++) {
+        char c = str[i];
+        if (c == '%' && i + 2 < str.size()) {
+            c = (char)strtoul(str.substr(i + 1, 2).c_str(), NULL, 16);
+            i += 2;
+        }
+        unescaped.append(&c, 1);
+    }
+    return unescaped;
+}
+
+template <typename T>
+static bool FormatNumbers(const MsgArg* value, const char* signature, bool array, String& line) {
+    size_t numElements = 1;
+    T element = 0;
+    T* elements = &element;
+    QStatus status = array ? value->Get(signature, &numElements, &elements) : value->Get(signature, &element);
+    for (size_t i = 0; status == ER_OK && i < numElements; i++) {
+        line += " " + I64ToString(elements[i]);
+    }
+    return status == ER_OK;
+}
+
+template <typename T>
+static bool SetNumbers(MsgArg& value, const char* signature, bool array, const std::vector<String>& tokens) {
+    std::vector<T> numbers;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        numbers.push_back((T)StringToI64(tokens[i]));
+    }
+    QStatus status = ER_BAD_ARG_COUNT;
+    if (array) {
+        status = value.Set(signature, numbers.size(), numbers.empty() ? NULL : &numbers[0]);
+    } else if (numbers.size() == 1) {
+        status = value.Set(signature, numbers[0]);
+    }
+    /* Copies the numbers before they go */
+    value.Stabilize();
+    return status == ER_OK;
+}
+
+/**
+ * Formats a {sv} capability parameter as "<name> <signature> <values>".
+ * Strings are prefixed with a quote so that an empty one is a value.
+ *
+ * @return false if the type of the value is not cached.
+ */
+static bool FormatParameter(const MsgArg& parameter, String& line) {
+    char* name = NULL;
+    MsgArg* value = NULL;
+    if (parameter.Get("{sv}", &name, &value) != ER_OK) {
+        return false;
+    }
+    String signature = value->Signature();
+    bool array = (signature.size() == 2 && signature[0] == 'a');
+    char type = signature[array ? 1 : 0];
+    if (signature.size() != (array ? 2U : 1U) || strchr(SINK_CACHE_PARAMETER_TYPES, type) == NULL) {
+        return false;
+    }
+
+    line = Escape(name) + " " + signature;
+    switch (type) {
+    case 'y':
+        return FormatNumbers<uint8_t>(value, signature.c_str(), array, line);
+
+    case 'n':
+        return FormatNumbers<int16_t>(value, signature.c_str(), array, line);
+
+    case 'q':
+        return FormatNumbers<uint16_t>(value, signature.c_str(), array, line);
+
+    case 'i':
+        return FormatNumbers<int32_t>(value, signature.c_str(), array, line);
+
+    case 'u':
+        return FormatNumbers<uint32_t>(value, signature.c_str(), array, line);
+
+    default: {
+            size_t numElements = 1;
+            MsgArg* elements = value;
+            if (array && value->Get("as", &numElements, &elements) != ER_OK) {
+                return false;
+            }
+            for (size_t i = 0; i < numElements; i++) {
+                char* str = NULL;
+                if (elements[i].Get("s", &str) != ER_OK) {
+                    return false;
+                }
+                line += " \"" + Escape(str);
+            }
+            return true;
+        }
+    }
+}
+
+static bool ParseParameter(const char* line, MsgArg& parameter) {
+    std::vector<String> tokens;
+    const char* start = line;
+    while (*start != '\0') {
+        const char* end = strchr(start, ' ');
+        if (end == NULL) {
+            end = start + strlen(start);
+        }
+        tokens.push_back(String(start, end - start));
+        start = (*end == ' ') ? end + 1 : end;
+    }
+    if (tokens.size() < 2) {
+        return false;
+    }
+
+    String name = Unescape(tokens[0]);
+    String signature = tokens[1];
+    tokens.erase(tokens.begin(), tokens.begin() + 2);
+    bool array = (signature.size() == 2 && signature[0] == 'a');
+    char type = signature[array ? 1 : 0];
+    if (signature.size() != (array ? 2U : 1U) || strchr(SINK_CACHE_PARAMETER_TYPES, type) == NULL) {
+        return false;
+    }
+
+    MsgArg value;
+    bool parsed = false;
+    switch (type) {
+    case 'y':
+        parsed = SetNumbers<uint8_t>(value, signature.c_str(), array, tokens);
+        break;
+
+    case 'n':
+        parsed = SetNumbers<int16_t>(value, signature.c_str(), array, tokens);
+        break;
+
+    case 'q':
+        parsed = SetNumbers<uint16_t>(value, signature.c_str(), array, tokens);
+        break;
+
+    case 'i':
+        parsed = SetNumbers<int32_t>(value, signature.c_str(), array, tokens);
+        break;
+
+    case 'u':
+        parsed = SetNumbers<uint32_t>(value, signature.c_str(), array, tokens);
+        break;
+
+    default: {
+            std::vector<String> strs;
+            std::vector<const char*> ptrs;
+            for (size_t i = 0; i < tokens.size(); i++) {
+                if (tokens[i].empty() || tokens[i][0] != '"') {
+                    return false;
+                }
+                strs.push_back(Unescape(tokens[i].substr(1)));
+            }
+            for (size_t i = 0; i < strs.size(); i++) {
+                ptrs.push_back(strs[i].c_str());
+            }
+            if (array) {
+                parsed = value.Set("as", ptrs.size(), ptrs.empty() ? NULL : &ptrs[0]) == ER_OK;
+            } else {
+                parsed = ptrs.size() == 1 && value.Set("s", ptrs[0]) == ER_OK;
+            }
+            /* Copies the strings before they go */
+            value.Stabilize();
+            break;
+        }
+    }
+    if (!parsed) {
+        return false;
+    }
+
+    if (parameter.Set("{sv}", name.c_str(), &value) != ER_OK) {
+        return false;
+    }
+    parameter.Stabilize();
+    return true;
+}
+
+SinkCache::SinkCache() : mDirty(false) {
+}
+
+SinkCache::~SinkCache() {
+    Flush();
+}
+
+bool SinkCache::SetFile(const char* fileName) {
+    mMutex.Lock();
+    mFileName = (fileName != NULL) ? fileName : "";
+    bool loaded = mFileName.empty() || Load();
+    mMutex.Unlock();
+    return loaded;
+}
+
+bool SinkCache::Lookup(const String& key, SinkDescriptor& descriptor) {
+    mMutex.Lock();
+    DescriptorMap::iterator it = mDescriptors.find(key);
+    bool found = it != mDescriptors.end();
+    if (found) {
+        descriptor = it->second;
+    }
+    mMutex.Unlock();
+    return found;
+}
+
+void SinkCache::Store(const String& key, const SinkDescriptor& descriptor) {
+    if (!IsValid(descriptor) || key.find_first_of('\n') != String::npos) {
+        return;
+    }
+
+    mMutex.Lock();
+    mDescriptors[key] = descriptor;
+    mDirty = true;
+    mMutex.Unlock();
+}
+
+void SinkCache::Remove(const String& key) {
+    mMutex.Lock();
+    if (mDescriptors.erase(key) > 0) {
+        mDirty = true;
+    }
+    mMutex.Unlock();
+}
+
+void SinkCache::Flush() {
+    mMutex.Lock();
+    if (mDirty) {
+        Save();
+    }
+    mMutex.Unlock();
+}
+
+void SinkCache::Clear() {
+    mMutex.Lock();
+    mDescriptors.clear();
+    Save();
+    mMutex.Unlock();
+}
+
+bool SinkCache::IsValid(const SinkDescriptor& descriptor) {
+    if (descriptor.streamPath.empty() || descriptor.capabilities.empty()) {
+        return false;
+    }
+    if (!descriptor.interfaceXml.empty() && descriptor.interfaceXml.size() != descriptor.interfaces.size()) {
+        return false;
+    }
+
+    /* A capability is only cached whole */
+    for (size_t i = 0; i < descriptor.capabilities.size(); i++) {
+        const std::vector<MsgArg>& parameters = descriptor.capabilities[i].parameters;
+        for (size_t j = 0; j < parameters.size(); j++) {
+            String line;
+            if (!FormatParameter(parameters[j], line)) {
+                QCC_DbgHLPrintf(("Not caching a %s capability with an unsupported parameter", descriptor.capabilities[i].type.c_str()));
+                return false;
+            }
+        }
+    }
+
+    /* The port must be a child of the stream */
+    String prefix = descriptor.streamPath;
+    if (prefix != "/") {
+        prefix += "/";
+    }
+    if (descriptor.portPath.size() <= prefix.size() || descriptor.portPath.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    bool hasPort = false;
+    bool hasAudioSink = false;
+    for (size_t i = 0; i < descriptor.interfaces.size(); i++) {
+        hasPort |= (descriptor.interfaces[i] == PORT_INTERFACE);
+        hasAudioSink |= (descriptor.interfaces[i] == AUDIO_SINK_INTERFACE);
+    }
+    return hasPort && hasAudioSink;
+}
+
+bool SinkCache::Load() {
+    FILE* file = fopen(mFileName.c_str(), "r");
+    if (file == NULL) {
+        return errno == ENOENT;
+    }
+
+    char line[SINK_CACHE_LINE_SIZE];
+    bool hasVersion = (fgets(line, sizeof(line), file) != NULL);
+    if (hasVersion && strcmp(line, "version 1\n") == 0) {
+        /* Only had the capability types, the sinks are introspected again and the file replaced */
+        QCC_DbgHLPrintf(("Replacing sink cache %s of an older version", mFileName.c_str()));
+        fclose(file);
+        return true;
+    }
+    if (!hasVersion || strcmp(line, "version " SINK_CACHE_VERSION "\n") != 0) {
+        QCC_LogError(ER_FAIL, ("Ignoring sink cache %s with unknown version", mFileName.c_str()));
+        fclose(file);
+        return false;
+    }
+
+    DescriptorMap descriptors;
+    String key;
+    SinkDescriptor descriptor;
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), file) != NULL) {
+        size_t len = strlen(line);
+        if (len == 0 || line[len - 1] != '\n') {
+            valid = false;
+            break;
+        }
+        line[len - 1] = '\0';
+
+        char* value = strchr(line, ' ');
+        if (value == NULL) {
+            valid = false;
+            break;
+        }
+        *value++ = '\0';
+
+        if (strcmp(line, "sink") == 0) {
+            if (!key.empty()) {
+                descriptors[key] = descriptor;
+            }
+            key = value;
+            descriptor = SinkDescriptor();
+        } else if (key.empty()) {
+            valid = false;
+        } else if (strcmp(line, "stream") == 0) {
+            descriptor.streamPath = value;
+        } else if (strcmp(line, "port") == 0) {
+            descriptor.portPath = value;
+        } else if (strcmp(line, "interface") == 0) {
+            descriptor.interfaces.push_back(value);
+            descriptor.interfaceXml.push_back("");
+        } else if (strcmp(line, "xml") == 0) {
+            /* Unescaped once the whole XML is read, an escape may span two lines */
+            valid = !descriptor.interfaceXml.empty();
+            if (valid) {
+                descriptor.interfaceXml.back() += value;
+            }
+        } else if (strcmp(line, "capability") == 0) {
+            CapabilityDescriptor capability;
+            capability.type = value;
+            descriptor.capabilities.push_back(capability);
+        } else if (strcmp(line, "parameter") == 0) {
+            MsgArg parameter;
+            valid = !descriptor.capabilities.empty() && ParseParameter(value, parameter);
+            if (valid) {
+                descriptor.capabilities.back().parameters.push_back(parameter);
+            }
+        } else if (strcmp(line, "fifo") == 0) {
+            char type[SINK_CACHE_LINE_SIZE] = { 0 };
+            valid = sscanf(value, "%1023s %u %u", type, &descriptor.fifoBytesPerSecond, &descriptor.fifoSize) == 3;
+            descriptor.fifoType = type;
+        }
+        /* Unknown fields are skipped */
+    }
+    if (valid && !key.empty()) {
+        descriptors[key] = descriptor;
+    }
+    fclose(file);
+
+    if (!valid) {
+        QCC_LogError(ER_FAIL, ("Ignoring malformed sink cache %s", mFileName.c_str()));
+        return false;
+    }
+
+    for (DescriptorMap::iterator it = descriptors.begin(); it != descriptors.end(); ++it) {
+        for (size_t i = 0; i < it->second.interfaceXml.size(); i++) {
+            it->second.interfaceXml[i] = Unescape(it->second.interfaceXml[i]);
+        }
+        if (IsValid(it->second)) {
+            mDescriptors[it->first] = it->second;
+        } else {
+            QCC_DbgHLPrintf(("Dropping invalid sink cache entry %s", it->first.c_str()));
+        }
+    }
+    return true;
+}
+
+void SinkCache::Save() {
+    /* A file that can't be written is not retried until the descriptors change again */
+    mDirty = false;
+    if (mFileName.empty()) {
+        return;
+    }
+
+    /* Write a new file and rename it so that a crash never leaves a partial cache behind */
+    String tmpFileName = mFileName + ".tmp";
+    FILE* file = fopen(tmpFileName.c_str(), "w");
+    if (file == NULL) {
+        QCC_LogError(ER_OS_ERROR, ("Failed to write sink cache %s", tmpFileName.c_str()));
+        return;
+    }
+
+    fprintf(file, "version " SINK_CACHE_VERSION "\n");
+    for (DescriptorMap::iterator it = mDescriptors.begin(); it != mDescriptors.end(); ++it) {
+        const SinkDescriptor& descriptor = it->second;
+        fprintf(file, "sink %s\n", it->first.c_str());
+        fprintf(file, "stream %s\n", descriptor.streamPath.c_str());
+        fprintf(file, "port %s\n", descriptor.portPath.c_str());
+        for (size_t i = 0; i < descriptor.interfaces.size(); i++) {
+            fprintf(file, "interface %s\n", descriptor.interfaces[i].c_str());
+            String xml = (i < descriptor.interfaceXml.size()) ? Escape(descriptor.interfaceXml[i]) : "";
+            for (size_t pos = 0; pos < xml.size(); pos += SINK_CACHE_XML_CHUNK_SIZE) {
+                fprintf(file, "xml %s\n", xml.substr(pos, SINK_CACHE_XML_CHUNK_SIZE).c_str());
+            }
+        }
+        for (size_t i = 0; i < descriptor.capabilities.size(); i++) {
+            const CapabilityDescriptor& capability = descriptor.capabilities[i];
+            fprintf(file, "capability %s\n", capability.type.c_str());
+            for (size_t j = 0; j < capability.parameters.size(); j++) {
+                String parameter;
+                if (FormatParameter(capability.parameters[j], parameter)) {
+                    fprintf(file, "parameter %s\n", parameter.c_str());
+                }
+            }
+        }
+        if (descriptor.fifoSize != 0) {
+            fprintf(file, "fifo %s %u %u\n", descriptor.fifoType.c_str(), descriptor.fifoBytesPerSecond, descriptor.fifoSize);
+        }
+    }
+
+    bool written = (fflush(file) == 0);
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(tmpFileName.c_str(), mFileName.c_str()) != 0) {
+        QCC_LogError(ER_OS_ERROR, ("Failed to write sink cache %s", mFileName.c_str()));
+        remove(tmpFileName.c_str());
+    }
+}
+
+}
+}
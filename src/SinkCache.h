@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _SINKCACHE_H
+#define _SINKCACHE_H
+
+#ifndef __cplusplus
+#error Only include SinkCache.h in C++ code.
+#endif
+
+#include <alljoyn/MsgArg.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace ajn {
+namespace services {
+
+/**
+ * A media type supported by a port, with its parameters.
+ */
+struct CapabilityDescriptor {
+    qcc::String type; /**< The media type. */
+    std::vector<ajn::MsgArg> parameters; /**< The {sv} parameters of the media type. */
+};
+
+/**
+ * What was learned about a sink by introspecting it, so that it can be
+ * reopened without doing so again.
+ */
+struct SinkDescriptor {
+    qcc::String streamPath; /**< The object path of the stream. */
+    qcc::String portPath; /**< The object path of the AudioSink port. */
+    std::vector<qcc::String> interfaces; /**< The interfaces implemented by the port. */
+    std::vector<qcc::String> interfaceXml; /**< The introspection XML of each interface, so that interfaces the player does not define are restored too. */
+    std::vector<CapabilityDescriptor> capabilities; /**< The capabilities of the port. */
+    qcc::String fifoType; /**< The media type the port was connected with when fifoSize was read. */
+    uint32_t fifoBytesPerSecond; /**< The input rate the port was connected with when fifoSize was read. */
+    uint32_t fifoSize; /**< The FIFO size of the port, or 0 if not known. */
+    SinkDescriptor() : fifoBytesPerSecond(0), fifoSize(0) { }
+};
+
+/**
+ * The sink descriptors, keyed by About device ID and app ID, optionally
+ * backed by a file so that they survive a restart.
+ */
+class SinkCache {
+  public:
+    SinkCache();
+
+    /**
+     * The destructor, which writes any changes not yet flushed.
+     */
+    ~SinkCache();
+
+    /**
+     * Sets the file backing the cache and loads any descriptors in it.
+     *
+     * @param[in] fileName the file to use, or NULL to keep the cache in
+     *                     memory only.
+     *
+     * @return true if the file was loaded or does not exist yet.
+     */
+    bool SetFile(const char* fileName);
+
+    /**
+     * Gets a descriptor.
+     *
+     * @param[in] key the key of the sink.
+     * @param[out] descriptor the descriptor.
+     *
+     * @return true if the sink is in the cache.
+     */
+    bool Lookup(const qcc::String& key, SinkDescriptor& descriptor);
+
+    /**
+     * Adds or replaces a descriptor.  The file is written by Flush(), so
+     * that opening many sinks writes it once.
+     *
+     * @param[in] key the key of the sink.
+     * @param[in] descriptor the descriptor.
+     */
+    void Store(const qcc::String& key, const SinkDescriptor& descriptor);
+
+    /**
+     * Removes a descriptor, for example when it turns out to be stale.
+     * The file is written by Flush().
+     *
+     * @param[in] key the key of the sink.
+     */
+    void Remove(const qcc::String& key);
+
+    /**
+     * Writes the file if the descriptors changed since it was last
+     * written.
+     */
+    void Flush();
+
+    /**
+     * Removes all descriptors.
+     */
+    void Clear();
+
+  private:
+    bool Load();
+    void Save();
+    static bool IsValid(const SinkDescriptor& descriptor);
+
+    typedef std::map<qcc::String, SinkDescriptor> DescriptorMap;
+
+    qcc::Mutex mMutex;
+    qcc::String mFileName;
+    DescriptorMap mDescriptors;
+    bool mDirty; /* The descriptors changed since the file was written */
+};
+
+}
+}
+
+#endif /* _SINKCACHE_H */
@@ -18,11 +18,18 @@
 #include <alljoyn/audio/SinkPlayer.h>
 
 #include "Clock.h"
+#include "SharedMutex.h"
 #include "Sink.h"
+#include "SinkCache.h"
+#include "TrackQueue.h"
+#include "WorkerPool.h"
 #include <alljoyn/audio/Audio.h>
 #include <alljoyn/audio/AudioCodec.h>
+#include <alljoyn/DBusStd.h>
+#include <alljoyn/SessionPortListener.h>
 #include <qcc/Debug.h>
 #include <qcc/Mutex.h>
+#include <qcc/StringUtil.h>
 #include <qcc/Thread.h>
 #include <algorithm>
 #include <inttypes.h>
@@ -34,6 +41,33 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
 
+#define DATA_READY_POLL_INTERVAL 10 /* ms between checks of a data source that cannot signal readiness */
+
+#define CONTROL_WORKERS 8 /* Threads running AddSink, RemoveSink and OpenAllSinks jobs */
+#define EMIT_WORKERS 2 /* Threads emitting audio, each serving many sinks */
+#define FIFO_POSITION_RETRIES 15
+#define FIFO_POSITION_TIMEOUT 2000 /* ms */
+#define FIFO_POSITION_RETRY_INTERVAL 2000 /* ms */
+#define MAX_PACKETS_PER_TURN 8 /* Packets sent to one sink before the worker moves on to the next */
+#define START_LEAD_MARGIN 100000000 /* 0.1s added to the worst sink round trip time */
+#define PACKET_EMIT_TIME 1000000 /* 1ms, the estimated time to send one Data signal */
+#define LOW_LATENCY_START_LEAD_MARGIN 20000000 /* 0.02s, used when every sink achieved the low latency profile */
+#define LOW_LATENCY_MAX_PACKET_DURATION 20 /* ms, a fifth of the low latency sink FIFO */
+#define MIN_PACKET_DURATION 5 /* ms */
+#define MAX_PACKET_DURATION 370 /* ms, about FRAMES_PER_PACKET at 44.1kHz */
+#define DEFAULT_PACKET_DURATION 100 /* ms */
+#define PACKET_SHRINK_BURSTS 8 /* Healthy refills before trying smaller raw packets */
+#define PACKET_HISTORY_DURATION 5000 /* ms of packets kept behind the emitters, the FIFO of a normal sink */
+#define DEFAULT_READ_AHEAD_DURATION 500 /* ms of packets encoded ahead of the furthest emitter */
+#define SINK_STATS_INTERVAL 1000000000 /* 1s between SinkStatsChanged events */
+#define DEFAULT_FAST_FILL_DURATION 1000 /* ms, sent at full speed when a paced sink starts */
+#define DEFAULT_PACING_RATE 150 /* Percent of real time */
+#define PACING_BURST_DURATION 40 /* ms, the depth of a paced sink's token bucket */
+#define PACING_STAGGER_INTERVAL 100 /* ms, over which the paced refills of the sinks are spread */
+#define PACING_STAGGER_SLOTS 8
+#define GROUP_JOIN_POLL_INTERVAL 10 /* ms between checks of a sink waiting for its Join reply */
+#define MAX_GROUP_LAG 1000 /* ms a member may fall behind the rest of its group before it is sent its own packets */
+
 using namespace ajn;
 using namespace qcc;
 using namespace std;
@@ -42,6 +76,8 @@ namespace ajn {
 namespace services {
 
 class FifoPositionHandler;
+class PacketStream;
+struct GroupJoin;
 
 struct SinkInfo {
     enum {
@@ -49,26 +85,50 @@ struct SinkInfo {
         OPENED,
     } mState;
     char* serviceName;
+    char* cacheKey;
     SessionId sessionId;
     ProxyBusObject* portObj;
     ProxyBusObject* streamObj;
     uint32_t fifoSize;
+    bool creditFlowControl;
+    LatencyProfile::Type latencyProfile; /* The profile the sink achieved */
     size_t numCapabilities;
     Capability* capabilities;
-    AudioEncoder* encoder;
+    PacketStream* packetStream;
     Capability* selectedCapability;
     uint32_t framesPerPacket;
+    uint32_t maxFramesPerPacket;
+    bool fixedPacketSize; /* The sink predates variable packet sizes and expects FRAMES_PER_PACKET frames */
     FifoPositionHandler* fifoPositionHandler;
-    uint32_t inputDataBytesRemaining;
-    qcc::Mutex timestampMutex;
-    uint64_t timestamp;
+    uint64_t inputOffset; /* The offset of the next packet in the data source */
+    uint64_t rtt; /* Smoothed control round trip time in nanos, follows increases immediately */
+    qcc::Mutex clockMutex; /* Guards clock and inputOffset, and packetStream while emitting */
+    MediaClock clock;
+    qcc::Mutex statsMutex;
+    SinkStats stats;
+    uint64_t fifoPositionTotal; /* Sum of the FIFO positions at refills, for the average */
+    uint64_t encodeTimeTotal; /* Sum of the encode times of the emitted packets, for the average */
+    uint64_t nextStatsTime; /* When the listeners are next sent a snapshot of the stats */
+    MultipointGroup* group; /* The sinks this one can share packets with, if any */
+    bool grouped; /* Joined the group's session, so its packets are signalled for the whole group */
+    bool groupRefused; /* Failed to join the group's session, or fell too far behind the group */
+    GroupJoin* groupJoin; /* The Join call in flight, guarded by groupJoinMutex and the group's mutex */
+    qcc::String memberName; /* The unique name the sink joined the group's session with */
+    uint32_t flushGeneration; /* Changed by Seek so that the reply to an earlier Flush is ignored, guarded by clockMutex */
+    SinkInfo() : mState(CLOSED), serviceName(NULL), cacheKey(NULL), sessionId(0), portObj(NULL), streamObj(NULL),
+        fifoSize(0), creditFlowControl(false), latencyProfile(LatencyProfile::NORMAL), numCapabilities(0),
+        capabilities(NULL), packetStream(NULL), selectedCapability(NULL), framesPerPacket(0), maxFramesPerPacket(0),
+        fixedPacketSize(false), fifoPositionHandler(NULL), inputOffset(0), rtt(0), fifoPositionTotal(0), encodeTimeTotal(0),
+        nextStatsTime(0), group(NULL), grouped(false), groupRefused(false), groupJoin(NULL), flushGeneration(0) { }
 };
 
-struct FindSink {
-    FindSink(const char* name) : name(name) { }
-    bool operator()(const SinkInfo& sink) { return (strcmp(sink.serviceName, name) == 0); }
-    const char* name;
-};
+static void AddRttSample(SinkInfo* si, uint64_t rtt) {
+    if (rtt > si->rtt) {
+        si->rtt = rtt;
+    } else {
+        si->rtt = (7 * si->rtt + rtt) / 8;
+    }
+}
 
 class SignallingObject : public BusObject {
   private:
@@ -97,7 +157,7 @@ class SignallingObject : public BusObject {
     }
 
   public:
-    SignallingObject(BusAttachment* bus) : BusObject("/Player/Out/Audio") {
+    SignallingObject(BusAttachment* bus, const char* path) : BusObject(path) {
         const InterfaceDescription* audioSourceIntf = bus->GetInterface(AUDIO_SOURCE_INTERFACE);
         assert(audioSourceIntf);
         AddInterface(*audioSourceIntf);
@@ -106,7 +166,7 @@ class SignallingObject : public BusObject {
         assert(mAudioDataMember);
     }
 
-    QStatus EmitAudioDataSignal(SessionId sessionId, uint8_t* data, int32_t dataSize, uint64_t timestamp) {
+    QStatus EmitAudioDataSignal(SessionId sessionId, const uint8_t* data, int32_t dataSize, uint64_t timestamp) {
         MsgArg args[2];
         args[0].Set("t", timestamp);
         args[1].Set("ay", dataSize, data);
@@ -121,13 +181,41 @@ class SignallingObject : public BusObject {
     }
 };
 
+/**
+ * A FifoPosition read in flight.  The handler is cleared if the sink is
+ * closed before the reply arrives.
+ */
+struct FifoPositionQuery {
+    FifoPositionHandler* handler;
+};
+
+static Mutex fifoPositionQueryMutex;
+
+/**
+ * Receives the FifoPosition replies.  It outlives every sink, so a reply
+ * that arrives after its sink was closed is dropped safely.
+ */
+class FifoPositionQueryListener : public ProxyBusObject::Listener {
+  public:
+    void GetFifoPositionCB(QStatus status, ProxyBusObject* obj, const MsgArg& value, void* context);
+};
+
+static FifoPositionQueryListener fifoPositionQueryListener;
+
 class FifoPositionHandler : public MessageReceiver {
   public:
-    FifoPositionHandler() : MessageReceiver() {
+    FifoPositionHandler() : MessageReceiver(), mHasFifoLevel(false), mFifoPosition(0), mFifoCredit(0),
+        mQuery(NULL), mHasQueryReply(false), mQueryStatus(ER_OK), mQueryPosition(0) {
         mReadyToEmitEvent = new Event();
     }
 
     ~FifoPositionHandler() {
+        fifoPositionQueryMutex.Lock();
+        if (mQuery != NULL) {
+            mQuery->handler = NULL;
+        }
+        fifoPositionQueryMutex.Unlock();
+
         delete mReadyToEmitEvent;
         mReadyToEmitEvent = NULL;
     }
@@ -137,6 +225,10 @@ class FifoPositionHandler : public MessageReceiver {
         assert(audioSinkIntf);
         const InterfaceDescription::Member* fifoPositionChangedMember = audioSinkIntf->GetMember("FifoPositionChanged");
         assert(fifoPositionChangedMember);
+        const InterfaceDescription* flowControlIntf = bus->GetInterface(AUDIO_SINK_FLOW_CONTROL_INTERFACE);
+        assert(flowControlIntf);
+        const InterfaceDescription::Member* fifoLevelChangedMember = flowControlIntf->GetMember("FifoLevelChanged");
+        assert(fifoLevelChangedMember);
 
         QStatus status = bus->RegisterSignalHandler(this,
                                                     static_cast<MessageReceiver::SignalHandler>(&FifoPositionHandler::FifoPositionChangedSignalHandler),
@@ -145,6 +237,13 @@ class FifoPositionHandler : public MessageReceiver {
             return status;
         }
 
+        status = bus->RegisterSignalHandler(this,
+                                            static_cast<MessageReceiver::SignalHandler>(&FifoPositionHandler::FifoLevelChangedSignalHandler),
+                                            fifoLevelChangedMember, objectPath);
+        if (status != ER_OK) {
+            return status;
+        }
+
         mReadyToEmitEvent->SetEvent();
         mSessionId = sessionId;
 
@@ -158,6 +257,10 @@ class FifoPositionHandler : public MessageReceiver {
         }
     }
 
+    Event& GetReadyToEmitEvent() {
+        return *mReadyToEmitEvent;
+    }
+
     QStatus WaitUntilReadyToEmit(uint32_t maxMs) {
         QStatus status = Event::Wait(*mReadyToEmitEvent, maxMs);
         if (status == ER_OK) {
@@ -166,6 +269,79 @@ class FifoPositionHandler : public MessageReceiver {
         return status;
     }
 
+    /**
+     * Gets the most recent FIFO level pushed by the sink.
+     *
+     * @return true if a FifoLevelChanged signal was received since the
+     *         last call, false if the caller must read FifoPosition.
+     */
+    bool GetFifoLevel(uint32_t& position, uint32_t& credit) {
+        mFifoLevelMutex.Lock();
+        bool hasFifoLevel = mHasFifoLevel;
+        position = mFifoPosition;
+        credit = mFifoCredit;
+        mHasFifoLevel = false;
+        mFifoLevelMutex.Unlock();
+        return hasFifoLevel;
+    }
+
+    /**
+     * Starts reading FifoPosition without waiting for the reply.  The
+     * ready to emit event is set when the reply arrives.
+     */
+    QStatus RequestFifoPosition(ProxyBusObject* portObj, uint32_t timeout) {
+        FifoPositionQuery* query = new FifoPositionQuery;
+        query->handler = this;
+        fifoPositionQueryMutex.Lock();
+        mQuery = query;
+        fifoPositionQueryMutex.Unlock();
+
+        QStatus status = portObj->GetPropertyAsync(AUDIO_SINK_INTERFACE, "FifoPosition", &fifoPositionQueryListener,
+                                                   static_cast<ProxyBusObject::Listener::GetPropertyCB>(&FifoPositionQueryListener::GetFifoPositionCB),
+                                                   query, timeout);
+        if (status != ER_OK) {
+            fifoPositionQueryMutex.Lock();
+            mQuery = NULL;
+            fifoPositionQueryMutex.Unlock();
+            delete query;
+        }
+        return status;
+    }
+
+    bool IsFifoPositionPending() {
+        fifoPositionQueryMutex.Lock();
+        bool pending = (mQuery != NULL);
+        fifoPositionQueryMutex.Unlock();
+        return pending;
+    }
+
+    /**
+     * Gets the reply to the last RequestFifoPosition().
+     *
+     * @return true if a reply arrived since the last call.
+     */
+    bool GetFifoPosition(QStatus& status, uint32_t& position) {
+        mFifoLevelMutex.Lock();
+        bool hasReply = mHasQueryReply;
+        status = mQueryStatus;
+        position = mQueryPosition;
+        mHasQueryReply = false;
+        mFifoLevelMutex.Unlock();
+        return hasReply;
+    }
+
+    /* Called by the listener with fifoPositionQueryMutex held */
+    void FifoPositionReply(QStatus status, uint32_t position) {
+        mQuery = NULL;
+        mFifoLevelMutex.Lock();
+        mQueryStatus = status;
+        mQueryPosition = position;
+        mHasQueryReply = true;
+        mFifoLevelMutex.Unlock();
+
+        mReadyToEmitEvent->SetEvent();
+    }
+
   private:
     void FifoPositionChangedSignalHandler(const InterfaceDescription::Member* member,
                                           const char* sourcePath, Message& msg)
@@ -187,9 +363,568 @@ class FifoPositionHandler : public MessageReceiver {
         mReadyToEmitEvent->SetEvent();
     }
 
+    void FifoLevelChangedSignalHandler(const InterfaceDescription::Member* member,
+                                       const char* sourcePath, Message& msg)
+    {
+        if (msg->GetSessionId() != mSessionId) {
+            // Ignore signal intended for different handler
+            return;
+        }
+
+        size_t numArgs = 0;
+        const MsgArg* args = NULL;
+        msg->GetArgs(numArgs, args);
+
+        if (numArgs != 2) {
+            QCC_LogError(ER_BAD_ARG_COUNT, ("FifoLevelChanged signal has invalid number of arguments"));
+            return;
+        }
+
+        mFifoLevelMutex.Lock();
+        mFifoPosition = args[0].v_uint32;
+        mFifoCredit = args[1].v_uint32;
+        mHasFifoLevel = true;
+        mFifoLevelMutex.Unlock();
+
+        mReadyToEmitEvent->SetEvent();
+    }
+
   private:
     Event* mReadyToEmitEvent;
     SessionId mSessionId;
+    qcc::Mutex mFifoLevelMutex;
+    bool mHasFifoLevel;
+    uint32_t mFifoPosition;
+    uint32_t mFifoCredit;
+    FifoPositionQuery* mQuery; /* The FifoPosition read in flight, guarded by fifoPositionQueryMutex */
+    bool mHasQueryReply;
+    QStatus mQueryStatus;
+    uint32_t mQueryPosition;
+};
+
+void FifoPositionQueryListener::GetFifoPositionCB(QStatus status, ProxyBusObject* obj, const MsgArg& value, void* context) {
+    FifoPositionQuery* query = reinterpret_cast<FifoPositionQuery*>(context);
+    uint32_t position = 0;
+    if (status == ER_OK) {
+        status = value.Get("u", &position);
+    }
+
+    fifoPositionQueryMutex.Lock();
+    if (query->handler != NULL) {
+        query->handler->FifoPositionReply(status, position);
+    }
+    fifoPositionQueryMutex.Unlock();
+    delete query;
+}
+
+/**
+ * A packet of encoded audio data.
+ */
+struct EncodedPacket {
+    uint64_t offset; /**< The byte offset of the unencoded data in the data source. */
+    uint32_t inputSize; /**< The size of the unencoded data (in bytes). */
+    const uint8_t* data; /**< The encoded data. */
+    uint32_t dataSize; /**< The size of data (in bytes). */
+    bool ownsData; /**< False if data is a view into the data source. */
+    uint64_t encodeTime; /**< The time taken to read and encode the data (in nanos). */
+};
+
+/**
+ * Reads and encodes the data source once for all sinks that selected
+ * the same capability.
+ *
+ * Each emitter acquires the packet at its read position and releases
+ * it once sent.  Packets are kept until every subscribed emitter has
+ * moved past them, and then for PACKET_HISTORY_DURATION more so that
+ * flushed audio and the prefill of a new sink are sent again without
+ * reading and encoding them again.
+ *
+ * The data source is read and the encoder run outside the lock on the
+ * kept packets, so that an emitter sending kept packets never waits on
+ * the read ahead or on another emitter encoding.
+ */
+class PacketStream {
+  public:
+    PacketStream(const char* type, TrackQueue* trackQueue, uint32_t framesPerPacket) :
+        mType(type), mTrackQueue(trackQueue), mEncoder(AudioEncoder::Create(type)), mReadAheadBytes(0), mReadBuffer(NULL), mRefCount(0) {
+        mEncoder->SetFrameSize(framesPerPacket);
+        mEncoder->Configure(mTrackQueue);
+        mFramesPerPacket = mEncoder->GetFrameSize();
+        mInputPacketBytes = mTrackQueue->GetBytesPerFrame() * mFramesPerPacket;
+        mHistoryBytes = (uint64_t)PACKET_HISTORY_DURATION * mTrackQueue->GetSampleRate() * mTrackQueue->GetBytesPerFrame() / 1000;
+    }
+
+    ~PacketStream() {
+        for (PacketMap::iterator it = mPackets.begin(); it != mPackets.end(); ++it) {
+            FreePacket(it->second);
+        }
+        mPackets.clear();
+
+        if (mReadBuffer != NULL) {
+            free((void*)mReadBuffer);
+            mReadBuffer = NULL;
+        }
+
+        delete mEncoder;
+    }
+
+    const qcc::String& GetType() const { return mType; }
+    uint32_t GetFrameSize() const { return mFramesPerPacket; }
+    uint32_t GetInputPacketBytes() const { return mInputPacketBytes; }
+
+    /**
+     * Gets the current encoder configuration.  This is suitable as the
+     * configuration parameter of Connect.
+     */
+    void GetConfiguration(Capability* configuration) {
+        mEncodeMutex.Lock();
+        mEncoder->GetConfiguration(configuration);
+        mEncodeMutex.Unlock();
+    }
+
+    /**
+     * Sets how far ahead of the furthest subscriber ReadAhead() encodes.
+     *
+     * @param[in] duration the read ahead depth in milliseconds, 0 to disable.
+     */
+    void SetReadAhead(uint32_t duration) {
+        mMutex.Lock();
+        mReadAheadBytes = (uint64_t)duration * mTrackQueue->GetSampleRate() * mTrackQueue->GetBytesPerFrame() / 1000;
+        mMutex.Unlock();
+    }
+
+    void Subscribe(const void* subscriber, uint64_t offset) {
+        mMutex.Lock();
+        mCursors[subscriber] = offset;
+        mMutex.Unlock();
+    }
+
+    void Unsubscribe(const void* subscriber) {
+        mMutex.Lock();
+        mCursors.erase(subscriber);
+        Trim();
+        mMutex.Unlock();
+    }
+
+    /**
+     * Gets the packet at offset, reading and encoding it if no other
+     * subscriber has done so already.
+     *
+     * @return ER_OK, or ER_EOF if there is no more data to read.
+     */
+    QStatus Acquire(const void* subscriber, uint64_t offset, EncodedPacket** packet) {
+        mMutex.Lock();
+        mCursors[subscriber] = offset;
+        PacketMap::iterator it = mPackets.find(offset);
+        bool found = (it != mPackets.end());
+        if (found) {
+            *packet = it->second;
+        }
+        mMutex.Unlock();
+
+        return found ? ER_OK : Produce(offset, packet);
+    }
+
+    /**
+     * @return true if the packet at offset is kept, so Acquire() will not
+     *         read the data source for it.
+     */
+    bool IsCached(uint64_t offset) {
+        mMutex.Lock();
+        bool found = (mPackets.find(offset) != mPackets.end());
+        mMutex.Unlock();
+        return found;
+    }
+
+    /**
+     * Reads and encodes the packet at offset ahead of any subscriber.
+     */
+    void Prefetch(uint64_t offset) {
+        EncodedPacket* packet = NULL;
+        Produce(offset, &packet);
+    }
+
+    /**
+     * Reads and encodes the packet after those kept ahead of the
+     * furthest subscriber, unless they already reach the read ahead
+     * depth or the data source has nothing ready.
+     *
+     * @return true if a packet was encoded.
+     */
+    bool ReadAhead() {
+        mMutex.Lock();
+        bool due = (mReadAheadBytes > 0) && !mCursors.empty();
+        uint64_t offset = 0;
+        if (due) {
+            uint64_t maxOffset = mCursors.begin()->second;
+            for (CursorMap::iterator it = mCursors.begin(); it != mCursors.end(); ++it) {
+                maxOffset = MAX(maxOffset, it->second);
+            }
+            offset = maxOffset;
+            PacketMap::iterator it;
+            while ((it = mPackets.find(offset)) != mPackets.end()) {
+                offset += it->second->inputSize;
+            }
+            due = (offset - maxOffset) < mReadAheadBytes;
+        }
+        mMutex.Unlock();
+
+        if (!due || offset >= mTrackQueue->GetInputSize64() || !mTrackQueue->IsDataReady(offset)) {
+            return false;
+        }
+        EncodedPacket* packet = NULL;
+        return Produce(offset, &packet) == ER_OK;
+    }
+
+    /**
+     * Moves the subscriber past an acquired packet.
+     */
+    void Release(const void* subscriber, uint64_t nextOffset) {
+        mMutex.Lock();
+        mCursors[subscriber] = nextOffset;
+        Trim();
+        mMutex.Unlock();
+    }
+
+    /**
+     * Gets the start of the earliest packet at or after earliest of those
+     * kept back to back up to offset.
+     *
+     * @return offset if the packet before offset is not kept.
+     */
+    uint64_t GetHistoryStart(uint64_t offset, uint64_t earliest) {
+        mMutex.Lock();
+        uint64_t start = offset;
+        PacketMap::iterator it = mPackets.lower_bound(offset);
+        while (it != mPackets.begin()) {
+            --it;
+            if (it->second->offset + it->second->inputSize != start || it->second->offset < earliest) {
+                break;
+            }
+            start = it->second->offset;
+        }
+        mMutex.Unlock();
+        return start;
+    }
+
+    void AddRef() { ++mRefCount; }
+    size_t DecRef() { return --mRefCount; }
+
+  private:
+    typedef std::map<uint64_t, EncodedPacket*> PacketMap;
+    typedef std::map<const void*, uint64_t> CursorMap;
+
+    QStatus Produce(uint64_t offset, EncodedPacket** packet) {
+        mEncodeMutex.Lock();
+        mMutex.Lock();
+        PacketMap::iterator it = mPackets.find(offset);
+        bool found = (it != mPackets.end());
+        if (found) {
+            /* Encoded while this one waited for the encoder */
+            *packet = it->second;
+        }
+        mMutex.Unlock();
+
+        QStatus status = ER_OK;
+        if (!found) {
+            status = Encode(offset, packet);
+        }
+        if (status == ER_OK && !found) {
+            mMutex.Lock();
+            mPackets[offset] = *packet;
+            mMutex.Unlock();
+        }
+        mEncodeMutex.Unlock();
+        return status;
+    }
+
+    QStatus Encode(uint64_t offset, EncodedPacket** packet) {
+        uint64_t start = GetCurrentTimeNanos();
+        if (mType == MIMETYPE_AUDIO_RAW && (size_t)offset == offset) {
+            /* Raw data is sent as is, so send straight from the data source when it allows */
+            const uint8_t* view = NULL;
+            size_t numBytes = mTrackQueue->GetDataView(&view, (size_t)offset, mInputPacketBytes);
+            if (numBytes > 0) {
+                EncodedPacket* p = new EncodedPacket;
+                p->offset = offset;
+                p->inputSize = numBytes;
+                p->data = view;
+                p->dataSize = numBytes;
+                p->ownsData = false;
+                p->encodeTime = GetCurrentTimeNanos() - start;
+                *packet = p;
+                return ER_OK;
+            }
+        }
+
+        uint8_t* input = (mReadBuffer != NULL) ? mReadBuffer : (uint8_t*)malloc(mInputPacketBytes);
+        mReadBuffer = NULL;
+
+        size_t numBytes = mTrackQueue->ReadData64(input, offset, mInputPacketBytes);
+        if (numBytes == 0) {
+            mReadBuffer = input;
+            return ER_EOF;
+        }
+
+        uint8_t* buffer = input;
+        uint32_t numBytesToEmit = numBytes;
+        mEncoder->Encode(&buffer, &numBytesToEmit);
+
+        EncodedPacket* p = new EncodedPacket;
+        p->offset = offset;
+        p->inputSize = numBytes;
+        p->dataSize = numBytesToEmit;
+        p->ownsData = true;
+        p->encodeTime = GetCurrentTimeNanos() - start;
+        if (buffer == input) {
+            /* Encoded in place, take ownership of the read buffer */
+            p->data = input;
+        } else {
+            uint8_t* data = (uint8_t*)malloc(numBytesToEmit);
+            memcpy(data, buffer, numBytesToEmit);
+            p->data = data;
+            mReadBuffer = input;
+        }
+
+        *packet = p;
+        return ER_OK;
+    }
+
+    void Trim() {
+        if (mCursors.empty()) {
+            return;
+        }
+        uint64_t minOffset = mCursors.begin()->second;
+        for (CursorMap::iterator it = mCursors.begin(); it != mCursors.end(); ++it) {
+            minOffset = MIN(minOffset, it->second);
+        }
+        uint64_t historyStart = (minOffset > mHistoryBytes) ? minOffset - mHistoryBytes : 0;
+        while (!mPackets.empty()) {
+            EncodedPacket* p = mPackets.begin()->second;
+            if (p->offset + p->inputSize > historyStart) {
+                break;
+            }
+            mPackets.erase(mPackets.begin());
+            FreePacket(p);
+        }
+    }
+
+    void FreePacket(EncodedPacket* p) {
+        if (p->ownsData) {
+            free((void*)p->data);
+        } else {
+            /* Lets the track go once no packet points into it */
+            mTrackQueue->ReleaseDataView(p->offset);
+        }
+        delete p;
+    }
+
+    qcc::String mType;
+    TrackQueue* mTrackQueue;
+    AudioEncoder* mEncoder;
+    uint32_t mFramesPerPacket;
+    uint32_t mInputPacketBytes;
+    uint64_t mHistoryBytes; /* Input bytes of packets kept behind the slowest subscriber */
+    uint64_t mReadAheadBytes; /* Input bytes of packets encoded ahead of the furthest subscriber */
+    uint8_t* mReadBuffer;
+    size_t mRefCount;
+    qcc::Mutex mEncodeMutex; /* Held while reading and encoding, taken before mMutex */
+    qcc::Mutex mMutex;
+    PacketMap mPackets;
+    CursorMap mCursors;
+};
+
+/**
+ * The emit state of a sink that is playing.
+ */
+struct EmitTask {
+    SinkPlayer* sp;
+    SinkInfo* si;
+    bool filled; /* The initial fill of the sink's FIFO has been sent */
+    uint32_t retries; /* Number of timed out FifoPosition reads */
+    uint32_t healthyBursts; /* Refills in a row that found the FIFO comfortably full */
+    uint64_t retryTime; /* When to retry a timed out FifoPosition read */
+    uint32_t burstBytes; /* FIFO space still to be sent at once, over several turns of the worker */
+    bool burstRefill; /* The burst refills the FIFO rather than filling it at the start */
+    uint32_t burstRequested; /* The FIFO space the burst was started with */
+    bool paced; /* Refills are sent at the paced rate rather than at once */
+    uint32_t pacedBytes; /* FIFO space still to be sent at the paced rate */
+    bool refillSkipped; /* A packet was skipped since the last refill */
+    uint64_t tokens; /* Bytes the token bucket lets through now */
+    uint64_t tokenTime; /* When the token bucket was last topped up */
+    uint64_t nextEmitTime; /* When the next paced packet is due */
+    uint64_t stagger; /* Delay in nanos before a paced refill starts, so that sinks refill apart */
+    Event* dataReadyEvent; /* Set when the data source has the packet the sink waits for */
+    volatile bool stopping;
+    volatile bool finished; /* Reached the end of the data source */
+    Event stopped;
+    EmitTask() : sp(NULL), si(NULL), filled(false), retries(0), healthyBursts(0), retryTime(0), burstBytes(0), burstRefill(false),
+        burstRequested(0), paced(false), pacedBytes(0), refillSkipped(false), tokens(0), tokenTime(0), nextEmitTime(0), stagger(0), dataReadyEvent(NULL), stopping(false), finished(false) { }
+};
+
+/**
+ * A thread that emits audio to a set of sinks, refilling each sink as
+ * its FIFO drains.  The sinks may belong to different players.
+ */
+struct EmitWorker {
+    Thread* thread;
+    Mutex mutex;
+    Event wakeEvent;
+    std::list<EmitTask*> tasks;
+    EmitWorker() : thread(NULL) { }
+};
+
+/**
+ * A thread that keeps packets encoded ahead of the emitters of every
+ * player, so that emitting never waits on the data source or encoder.
+ */
+struct ReadAheadWorker {
+    Thread* thread;
+    Mutex mutex; /* Held while reading ahead, so a stream is not deleted under the thread */
+    Event wakeEvent;
+    std::set<PacketStream*> streams;
+    ReadAheadWorker() : thread(NULL) { }
+};
+
+/**
+ * The threads shared by every player in the process, so that each
+ * additional zone costs sinks rather than threads.
+ */
+struct SharedWorkers {
+    WorkerPool* controlPool;
+    std::vector<EmitWorker*> emitWorkers;
+    ReadAheadWorker* readAheadWorker;
+    std::set<uint32_t> zones; /* Zones of the players using the workers */
+    uint32_t nextStaggerSlot; /* Spreads paced refills across the sinks of every player */
+    SharedWorkers() : controlPool(NULL), readAheadWorker(NULL), nextStaggerSlot(0) { }
+};
+
+static Mutex sharedWorkersMutex;
+static SharedWorkers sharedWorkers;
+
+/**
+ * Sinks that are sent the same packets over one multipoint session.  A
+ * packet is signalled once every member has taken it in, so that no
+ * member is sent more than its FIFO has room for.
+ */
+struct MultipointGroup {
+    Mutex mutex;
+    SessionPort port;
+    SessionId sessionId;
+    PacketStream* packetStream;
+    size_t numSinks; /* Sinks assigned to the group, whether or not they joined */
+    std::set<SinkInfo*> members; /* Sinks that joined the session */
+    uint64_t inputOffset; /* The offset of the next packet to signal */
+    MediaClock clock;
+    MultipointGroup() : port(0), sessionId(0), packetStream(NULL), numSinks(0), inputOffset(0) { }
+};
+
+/**
+ * A Join call in flight.  The sink is cleared if it leaves the group
+ * before the reply, which then only frees this.
+ */
+struct GroupJoin {
+    SinkInfo* si;
+    MultipointGroup* group;
+    GroupJoin() : si(NULL), group(NULL) { }
+};
+
+static Mutex groupJoinMutex; /* Guards GroupJoin::si, taken before the group's mutex */
+
+/**
+ * Lets sinks asked to Join into the multipoint sessions of the groups.
+ */
+class MultipointPortListener : public SessionPortListener {
+  public:
+    bool AcceptSessionJoiner(SessionPort sessionPort, const char* joiner, const SessionOpts& opts) {
+        return opts.isMultipoint;
+    }
+};
+
+struct VolumeCallInfo;
+
+/**
+ * Collects the replies to a command sent to a group of sinks at once.
+ */
+struct GroupCall {
+    Mutex mutex;
+    Event done;
+    size_t pending;
+    SinkPlayer::SinkResults results;
+    std::map<qcc::String, uint64_t> rtts;
+    std::map<qcc::String, MsgArg> values; /* The first argument of each reply that has one */
+    VolumeCallInfo* volumeCall; /* Set on the heap allocated group of an async volume call, finished by its last reply */
+    GroupCall() : pending(0), volumeCall(NULL) { done.SetEvent(); }
+
+    void Hold() {
+        mutex.Lock();
+        pending++;
+        done.ResetEvent();
+        mutex.Unlock();
+    }
+
+    /**
+     * @return true if this was the last outstanding call.
+     */
+    bool Release() {
+        mutex.Lock();
+        bool last = (--pending == 0);
+        if (last) {
+            done.SetEvent();
+        }
+        mutex.Unlock();
+        return last;
+    }
+
+    bool Complete(const qcc::String& name, QStatus status, uint64_t rtt = 0, const MsgArg* value = NULL) {
+        mutex.Lock();
+        /* A sink sent more than one call keeps its first failure */
+        SinkPlayer::SinkResults::iterator it = results.find(name);
+        if (it == results.end() || it->second == ER_OK) {
+            results[name] = status;
+        }
+        if (rtt != 0) {
+            rtts[name] = rtt;
+        }
+        if (value != NULL) {
+            values[name] = *value;
+        }
+        mutex.Unlock();
+        return Release();
+    }
+
+    bool Wait(SinkPlayer::SinkResults* out) {
+        Event::Wait(done);
+        bool success = true;
+        mutex.Lock();
+        for (SinkPlayer::SinkResults::iterator it = results.begin(); it != results.end(); ++it) {
+            success = success && (it->second == ER_OK);
+        }
+        if (out != NULL) {
+            *out = results;
+        }
+        mutex.Unlock();
+        return success;
+    }
+};
+
+struct GroupCallContext {
+    GroupCall* group;
+    qcc::String name;
+    const char* method;
+    uint64_t sendTime;
+};
+
+/**
+ * The Flush sent to a sink by Pause.  The sink is looked up by name
+ * when the reply arrives, as it may have been removed meanwhile.
+ */
+struct FlushCall {
+    SinkPlayer* sp;
+    qcc::String name;
+    uint32_t generation; /* The flushGeneration of the sink when the Flush was sent */
+    uint32_t flushedBytes; /* From the reply */
+    FlushCall() : sp(NULL), generation(0), flushedBytes(0) { }
 };
 
 class SinkSessionListener : public SessionListener {
@@ -206,21 +941,87 @@ class SinkSessionListener : public SessionListener {
     }
 };
 
+/**
+ * Appends a parameter to the configuration passed to Connect.
+ *
+ * @param[in] configuration the configuration to append to.
+ * @param[in] name the parameter name.
+ * @param[in] value the parameter value, ownership is transferred.
+ */
+static void AddConfigurationParameter(Capability* configuration, const char* name, MsgArg* value) {
+    MsgArg* parameters = new MsgArg[configuration->numParameters + 1];
+    for (size_t i = 0; i < configuration->numParameters; i++)
+        parameters[i] = configuration->parameters[i];
+    parameters[configuration->numParameters].Set("{sv}", name, value);
+    parameters[configuration->numParameters].SetOwnershipFlags(MsgArg::OwnsArgs, true);
+
+    delete [] configuration->parameters;
+    configuration->parameters = parameters;
+    configuration->numParameters++;
+}
+
 SinkPlayer::SinkPlayer(BusAttachment* msgBus)
-    : MessageReceiver(), mSinkListenersMutex(new qcc::Mutex()), mDataSource(NULL),
-    mSinksMutex(new qcc::Mutex()), mAddThreadsMutex(new qcc::Mutex()), mRemoveThreadsMutex(new qcc::Mutex()),
-    mEmitThreadsMutex(new qcc::Mutex()), mSinkListenerThread(NULL) {
+    : MessageReceiver(), mSinkListenersMutex(new qcc::Mutex()), mDataSource(NULL), mTrackQueue(NULL),
+    mNextDataSourceMutex(new qcc::Mutex()), mNextDataSource(NULL), mChangingDataSource(false),
+    mSinksMutex(new SharedMutex()), mPendingAddsMutex(new qcc::Mutex()), mPendingRemovesMutex(new qcc::Mutex()),
+    mPendingOpensMutex(new qcc::Mutex()), mEmitTasksMutex(new qcc::Mutex()), mPacketStreamsMutex(new qcc::Mutex()),
+    mVolumeCacheMutex(new qcc::Mutex()), mPendingVolumeCalls(0), mVolumeCallsDoneEvent(new qcc::Event()), mGroupsMutex(new qcc::Mutex()), mMultipointPortListener(new MultipointPortListener()),
+    mSinkListenerThread(NULL) {
     mMsgBus = msgBus;
     mSessionListener = new SinkSessionListener(this);
     mPreferredFormat = strdup(MIMETYPE_AUDIO_RAW);
+    mLatencyProfile = LatencyProfile::NORMAL;
+    mMinPacketDuration = MIN_PACKET_DURATION;
+    mMaxPacketDuration = MAX_PACKET_DURATION;
+    mPacing = false;
+    mFastFillDuration = DEFAULT_FAST_FILL_DURATION;
+    mPacingRate = DEFAULT_PACING_RATE;
+    mMultipoint = false;
+    mReadAheadDuration = DEFAULT_READ_AHEAD_DURATION;
     mState = PlayerState::IDLE;
 
+    mSinkCache = new SinkCache();
+
+    /* The first player starts the workers, and takes the lowest free zone */
+    sharedWorkersMutex.Lock();
+    if (sharedWorkers.zones.empty()) {
+        sharedWorkers.controlPool = new WorkerPool("SinkControl", CONTROL_WORKERS);
+        for (int i = 0; i < EMIT_WORKERS; i++) {
+            EmitWorker* ew = new EmitWorker;
+            ew->thread = new Thread("EmitAudio", &EmitAudioThread);
+            sharedWorkers.emitWorkers.push_back(ew);
+            ew->thread->Start(ew);
+        }
+        sharedWorkers.readAheadWorker = new ReadAheadWorker;
+        sharedWorkers.readAheadWorker->thread = new Thread("ReadAhead", &ReadAheadThread);
+        sharedWorkers.readAheadWorker->thread->Start(sharedWorkers.readAheadWorker);
+    }
+    mZone = 0;
+    while (sharedWorkers.zones.count(mZone) > 0) {
+        mZone++;
+    }
+    sharedWorkers.zones.insert(mZone);
+    mControlPool = sharedWorkers.controlPool;
+    mEmitWorkers = sharedWorkers.emitWorkers;
+    mReadAheadWorker = sharedWorkers.readAheadWorker;
+    sharedWorkersMutex.Unlock();
+
+    /* Another player or stream on the bus may have created the interfaces already */
+    mSignallingObject = NULL;
     QStatus status = msgBus->CreateInterfacesFromXml(INTERFACES_XML);
-    if (status != ER_OK) {
+    if (status != ER_OK && msgBus->GetInterface(AUDIO_SOURCE_INTERFACE) == NULL) {
         QCC_LogError(status, ("Failed to create interfaces from XML"));
     } else {
-        mSignallingObject = new SignallingObject(mMsgBus);
-        mMsgBus->RegisterBusObject(*mSignallingObject);
+        /* Zone 0 keeps the path used before there were zones */
+        String path = "/Player/Out/Audio";
+        if (mZone != 0) {
+            path += U32ToString(mZone);
+        }
+        mSignallingObject = new SignallingObject(mMsgBus, path.c_str());
+        status = mMsgBus->RegisterBusObject(*mSignallingObject);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to register %s", path.c_str()));
+        }
     }
 
     const InterfaceDescription* volumeIntf = mMsgBus->GetInterface(VOLUME_INTERFACE);
@@ -247,6 +1048,46 @@ SinkPlayer::SinkPlayer(BusAttachment* msgBus)
 SinkPlayer::~SinkPlayer() {
     RemoveAllSinks();
 
+    /* The replies to async volume calls arrive, if only as errors, once the sinks are gone */
+    mVolumeCacheMutex->Lock();
+    while (mPendingVolumeCalls > 0) {
+        mVolumeCallsDoneEvent->ResetEvent();
+        mVolumeCacheMutex->Unlock();
+        Event::Wait(*mVolumeCallsDoneEvent);
+        mVolumeCacheMutex->Lock();
+    }
+    mVolumeCacheMutex->Unlock();
+
+    /* Other players may still be using the workers, so only wait for this player's RemoveSink jobs */
+    mControlPool->Wait(this);
+    mControlPool = NULL;
+    mEmitWorkers.clear();
+
+    sharedWorkersMutex.Lock();
+    sharedWorkers.zones.erase(mZone);
+    if (sharedWorkers.zones.empty()) {
+        delete sharedWorkers.controlPool;
+        sharedWorkers.controlPool = NULL;
+        for (size_t i = 0; i < sharedWorkers.emitWorkers.size(); i++) {
+            EmitWorker* ew = sharedWorkers.emitWorkers[i];
+            ew->thread->Stop();
+            ew->thread->Join();
+            delete ew->thread;
+            delete ew;
+        }
+        sharedWorkers.emitWorkers.clear();
+        ReadAheadWorker* rw = sharedWorkers.readAheadWorker;
+        rw->thread->Stop();
+        rw->thread->Join();
+        delete rw->thread;
+        delete rw;
+        sharedWorkers.readAheadWorker = NULL;
+    }
+    sharedWorkersMutex.Unlock();
+
+    delete mSinkCache;
+    delete mTrackQueue;
+
     if (mSignallingObject != NULL) {
         mMsgBus->UnregisterBusObject(*mSignallingObject);
         delete mSignallingObject;
@@ -265,9 +1106,16 @@ SinkPlayer::~SinkPlayer() {
 
     mMsgBus->UnregisterAllHandlers(this);
 
-    delete mEmitThreadsMutex;
-    delete mRemoveThreadsMutex;
-    delete mAddThreadsMutex;
+    delete mMultipointPortListener;
+    delete mGroupsMutex;
+    delete mVolumeCallsDoneEvent;
+    delete mVolumeCacheMutex;
+    delete mPacketStreamsMutex;
+    delete mEmitTasksMutex;
+    delete mNextDataSourceMutex;
+    delete mPendingOpensMutex;
+    delete mPendingRemovesMutex;
+    delete mPendingAddsMutex;
     delete mSinksMutex;
     delete mSinkListenersMutex;
 }
@@ -284,71 +1132,437 @@ bool SinkPlayer::SetDataSource(DataSource* theSource) {
     }
     mSinksMutex->Unlock();
 
-    mDataSource = theSource;
+    /* Played through a queue so that more data sources can follow without a gap */
+    std::vector<DataSource*> finished;
+    mNextDataSourceMutex->Lock();
+    if (mTrackQueue != NULL) {
+        mTrackQueue->GetDataSources(finished);
+    }
+    if (mNextDataSource != NULL) {
+        finished.push_back(mNextDataSource);
+    }
+    delete mTrackQueue;
+    mTrackQueue = (theSource != NULL) ? new TrackQueue(theSource) : NULL;
+    mDataSource = mTrackQueue;
+    mNextDataSource = NULL;
+    mChangingDataSource = false;
+    mNextDataSourceMutex->Unlock();
     mState = PlayerState::INIT;
+    NotifyDataSourcesFinished(finished);
 
     return true;
 }
 
-bool SinkPlayer::SetPreferredFormat(const char* format) {
-    if (!AudioEncoder::CanCreate(format)) {
+bool SinkPlayer::SetNextDataSource(DataSource* dataSource) {
+    if (mState == PlayerState::IDLE || dataSource == NULL) {
+        QCC_LogError(ER_FAIL, ("SetDataSource must be called before SetNextDataSource"));
         return false;
     }
-    char* oldFormat = mPreferredFormat;
-    mPreferredFormat = strdup(format);
-    if (oldFormat != NULL) {
-        free((void*)oldFormat);
+
+    mNextDataSourceMutex->Lock();
+    if (mNextDataSource != NULL || mChangingDataSource) {
+        mNextDataSourceMutex->Unlock();
+        QCC_LogError(ER_FAIL, ("A data source with another format is already queued"));
+        return false;
+    }
+
+    /* Nothing can follow a data source without an end */
+    if (mTrackQueue->GetInputSize64() == DataSource::UNBOUNDED_INPUT_SIZE) {
+        mNextDataSourceMutex->Unlock();
+        QCC_LogError(ER_FAIL, ("The data source has no end"));
+        return false;
     }
+
+    uint64_t start = 0;
+    if (!mTrackQueue->Append(dataSource, start)) {
+        /* Played after reconnecting the sinks once they have played out the queue */
+        QCC_DbgHLPrintf(("Next data source has another format"));
+        mNextDataSource = dataSource;
+        mNextDataSourceMutex->Unlock();
+        CheckEndOfQueue();
+        return true;
+    }
+    mNextDataSourceMutex->Unlock();
+
+    /* Encode the start of the track now so that it is ready when the emitters get there */
+    mPacketStreamsMutex->Lock();
+    for (PacketStreamMap::iterator it = mPacketStreams.begin(); it != mPacketStreams.end(); ++it) {
+        it->second->Prefetch(start);
+    }
+    mPacketStreamsMutex->Unlock();
+
+    RestartFinishedEmitters();
     return true;
 }
 
-void SinkPlayer::AddListener(SinkListener* listener) {
-    mSinkListenersMutex->Lock();
-    mSinkListeners.insert(listener);
-    if (!mSinkListenerThread) {
-        mSinkListenerThread = new Thread("SinkListener", &SinkListenerThread);
-        mSinkListenerThread->Start(this);
+void SinkPlayer::RestartFinishedEmitters() {
+    if (mState != PlayerState::PLAYING) {
+        return;
     }
-    mSinkListenersMutex->Unlock();
+
+    std::list<SinkInfo*> sinks;
+    mSinksMutex->Lock();
+    mEmitTasksMutex->Lock();
+    for (std::map<qcc::String, EmitTask*>::iterator it = mEmitTasks.begin(); it != mEmitTasks.end(); ++it) {
+        if (it->second->finished) {
+            sinks.push_back(it->second->si);
+        }
+    }
+    mEmitTasksMutex->Unlock();
+
+    if (!sinks.empty()) {
+        /* The queue ran out before more was added, continue the timeline unless it is already in the past */
+        StopEmitting(sinks);
+        StartLead startLead = ComputeStartLead();
+        uint64_t timestamp = GetCurrentTimeNanos() + startLead.lead;
+        for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+            SinkInfo* si = *it;
+            si->clockMutex.Lock();
+            if (si->clock.GetTime() < timestamp) {
+                si->clock.Set(mDataSource->GetSampleRate(), si->clock.GetPosition(), timestamp);
+            }
+            si->clockMutex.Unlock();
+            StartEmitting(si);
+        }
+    }
+    mSinksMutex->Unlock();
 }
 
-void SinkPlayer::RemoveListener(SinkListener* listener) {
-    mSinkListenersMutex->Lock();
-    SinkListeners::iterator it = mSinkListeners.find(listener);
-    if (it != mSinkListeners.end()) {
-        mSinkListeners.erase(it);
+void SinkPlayer::CheckEndOfQueue() {
+    mNextDataSourceMutex->Lock();
+    bool change = (mNextDataSource != NULL && !mChangingDataSource && mState == PlayerState::PLAYING);
+    if (change) {
+        /* Wait for every sink to play out the queue */
+        mEmitTasksMutex->Lock();
+        change = !mEmitTasks.empty();
+        for (std::map<qcc::String, EmitTask*>::iterator it = mEmitTasks.begin(); it != mEmitTasks.end(); ++it) {
+            change = change && it->second->finished;
+        }
+        mEmitTasksMutex->Unlock();
     }
-    if (mSinkListeners.empty()) {
-        mSinkListenerThread->Stop();
-        mSinkListenerThread->Join();
-        delete mSinkListenerThread;
-        mSinkListenerThread = NULL;
+    if (change) {
+        mChangingDataSource = true;
+        mControlPool->Execute(&ChangeDataSourceJob, this, this);
     }
-    mSinkListenersMutex->Unlock();
+    mNextDataSourceMutex->Unlock();
 }
 
-struct AddSinkInfo {
-    char* name;
-    SessionPort port;
-    char* path;
+ThreadReturn SinkPlayer::ChangeDataSourceJob(void* arg) {
+    SinkPlayer* sp = reinterpret_cast<SinkPlayer*>(arg);
+    sp->ChangeDataSource();
+    return NULL;
+}
+
+struct DataSourceChange {
     SinkPlayer* sp;
-    AddSinkInfo() : name(NULL), path(NULL), sp(NULL) { }
+    qcc::Mutex mutex;
+    size_t pending; /* Sinks still being reconnected */
+    uint64_t endTime; /* When the old format finishes playing */
+    std::list<qcc::String> names;
+    std::list<qcc::String> connected;
+    DataSourceChange() : sp(NULL), pending(0), endTime(0) { }
 };
 
-bool SinkPlayer::AddSink(const char* name, SessionPort port, const char* path) {
+struct ReconnectSinkInfo {
+    char* name;
+    DataSourceChange* change;
+    ReconnectSinkInfo() : name(NULL), change(NULL) { }
+};
+
+void SinkPlayer::ChangeDataSource() {
     mSinksMutex->Lock();
-    bool exists = find_if(mSinks.begin(), mSinks.end(), FindSink(name)) != mSinks.end();
-    mSinksMutex->Unlock();
-    if (exists) {
+    mNextDataSourceMutex->Lock();
+    bool pending = (mNextDataSource != NULL);
+    mChangingDataSource = pending;
+    mNextDataSourceMutex->Unlock();
+    if (!pending) {
+        /* SetDataSource() was called in the meantime */
+        mSinksMutex->Unlock();
+        return;
+    }
+
+    DataSourceChange* change = new DataSourceChange;
+    change->sp = this;
+    std::list<SinkInfo*> sinks;
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        if (si->mState == SinkInfo::OPENED) {
+            sinks.push_back(si);
+            si->clockMutex.Lock();
+            change->endTime = MAX(change->endTime, si->clock.GetTime());
+            si->clockMutex.Unlock();
+        }
+    }
+    StopEmitting(sinks);
+
+    /* The packet streams read from the old queue, so release them before it goes */
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        SinkInfo* si = *it;
+        LeaveGroup(si);
+        ReleasePacketStream(si->packetStream);
+        si->packetStream = NULL;
+        delete si->selectedCapability;
+        si->selectedCapability = NULL;
+        /* Out of play until reconnected, and kept from being opened meanwhile like a sink being opened */
+        si->mState = SinkInfo::CLOSED;
+        change->names.push_back(si->serviceName);
+    }
+
+    std::vector<DataSource*> finished;
+    mNextDataSourceMutex->Lock();
+    mTrackQueue->GetDataSources(finished);
+    delete mTrackQueue;
+    mTrackQueue = new TrackQueue(mNextDataSource);
+    mDataSource = mTrackQueue;
+    mNextDataSource = NULL;
+    mChangingDataSource = false;
+    mNextDataSourceMutex->Unlock();
+
+    mPendingOpensMutex->Lock();
+    for (std::list<qcc::String>::iterator it = change->names.begin(); it != change->names.end(); ++it) {
+        mPendingOpens.insert(*it);
+    }
+    mPendingOpensMutex->Unlock();
+    mSinksMutex->Unlock();
+
+    NotifyDataSourcesFinished(finished);
+
+    /* Each sink takes a few round trips to reconnect, so they are reconnected in parallel */
+    if (change->names.empty()) {
+        delete change;
+        return;
+    }
+    change->pending = change->names.size();
+    for (std::list<qcc::String>::iterator it = change->names.begin(); it != change->names.end(); ++it) {
+        ReconnectSinkInfo* rsi = new ReconnectSinkInfo;
+        rsi->name = strdup(it->c_str());
+        rsi->change = change;
+        if (mControlPool->Execute(&ReconnectSinkJob, rsi, this) != ER_OK) {
+            rsi->change = NULL;
+            free((void*)rsi->name);
+            delete rsi;
+            ReconnectSinkDone(change, *it, ER_FAIL);
+        }
+    }
+}
+
+ThreadReturn SinkPlayer::ReconnectSinkJob(void* arg) {
+    ReconnectSinkInfo* rsi = reinterpret_cast<ReconnectSinkInfo*>(arg);
+    DataSourceChange* change = rsi->change;
+    SinkPlayer* sp = change->sp;
+
+    sp->mSinksMutex->LockShared();
+    SinkInfo* si = sp->LookupSink(rsi->name);
+    sp->mSinksMutex->UnlockShared();
+
+    QStatus status = ER_FAIL;
+    if (si != NULL) {
+        status = sp->ReconnectSink(si);
+    }
+    sp->ReconnectSinkDone(change, rsi->name, status);
+
+    free((void*)rsi->name);
+    delete rsi;
+    return NULL;
+}
+
+void SinkPlayer::ReconnectSinkDone(DataSourceChange* change, const qcc::String& name, QStatus status) {
+    change->mutex.Lock();
+    if (status == ER_OK) {
+        change->connected.push_back(name);
+    } else {
+        QCC_LogError(status, ("Failed to reconnect %s with the new format", name.c_str()));
+    }
+    bool last = (--change->pending == 0);
+    change->mutex.Unlock();
+    if (!last) {
+        return;
+    }
+
+    /* The last sink to finish puts them all back in play */
+    mSinksMutex->Lock();
+    for (std::list<qcc::String>::iterator it = change->names.begin(); it != change->names.end(); ++it) {
+        SinkInfo* si = LookupSink(it->c_str());
+        if (si == NULL) {
+            continue;
+        }
+        if (std::find(change->connected.begin(), change->connected.end(), *it) != change->connected.end()) {
+            si->clockMutex.Lock();
+            si->inputOffset = 0;
+            si->clockMutex.Unlock();
+            si->mState = SinkInfo::OPENED;
+        } else {
+            CloseSink(si);
+        }
+    }
+
+    /* Continue the timeline where the old format ended, unless reconnecting took longer */
+    StartLead startLead = ComputeStartLead();
+    uint64_t timestamp = MAX(change->endTime, GetCurrentTimeNanos() + startLead.lead + startLead.bufferTime);
+    for (std::list<qcc::String>::iterator it = change->connected.begin(); it != change->connected.end(); ++it) {
+        SinkInfo* si = LookupSink(it->c_str());
+        if (si == NULL) {
+            continue;
+        }
+        si->clockMutex.Lock();
+        si->clock.Set(mDataSource->GetSampleRate(), 0, timestamp);
+        si->clockMutex.Unlock();
+        if (mState == PlayerState::PLAYING) {
+            StartEmitting(si);
+        }
+    }
+
+    mPendingOpensMutex->Lock();
+    for (std::list<qcc::String>::iterator it = change->names.begin(); it != change->names.end(); ++it) {
+        mPendingOpens.erase(*it);
+    }
+    mPendingOpensMutex->Unlock();
+    mSinksMutex->Unlock();
+
+    delete change;
+}
+
+QStatus SinkPlayer::ReconnectSink(SinkInfo* si) {
+    /* The port can only be connected once per open, the session, ports and clock are kept */
+    Message closeReply(*mMsgBus);
+    QStatus status = si->streamObj->MethodCall(STREAM_INTERFACE, "Close", NULL, 0, closeReply);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Stream.Close() failed"));
+        return status;
+    }
+
+    Message openReply(*mMsgBus);
+    status = si->streamObj->MethodCall(STREAM_INTERFACE, "Open", NULL, 0, openReply);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Stream.Open() failed"));
+        return status;
+    }
+
+    SinkDescriptor descriptor;
+    return ConnectSink(si, descriptor);
+}
+
+bool SinkPlayer::SetPreferredFormat(const char* format) {
+    if (!AudioEncoder::CanCreate(format)) {
+        return false;
+    }
+    char* oldFormat = mPreferredFormat;
+    mPreferredFormat = strdup(format);
+    if (oldFormat != NULL) {
+        free((void*)oldFormat);
+    }
+    return true;
+}
+
+bool SinkPlayer::SetLatencyProfile(LatencyProfile::Type profile) {
+    if (profile != LatencyProfile::NORMAL && profile != LatencyProfile::LOW) {
+        return false;
+    }
+    mLatencyProfile = profile;
+    return true;
+}
+
+LatencyProfile::Type SinkPlayer::GetLatencyProfile(const char* name) {
+    LatencyProfile::Type profile = LatencyProfile::NORMAL;
+    mSinksMutex->LockShared();
+    SinkInfo* si = LookupSink(name);
+    if (si != NULL) {
+        profile = si->latencyProfile;
+    }
+    mSinksMutex->UnlockShared();
+    return profile;
+}
+
+bool SinkPlayer::SetPacketDuration(uint32_t minMs, uint32_t maxMs) {
+    if (minMs == 0 || minMs > maxMs) {
+        return false;
+    }
+    mMinPacketDuration = minMs;
+    mMaxPacketDuration = maxMs;
+    return true;
+}
+
+bool SinkPlayer::SetPacing(bool enabled, uint32_t fastFillMs, uint32_t ratePercent) {
+    if (ratePercent <= 100) {
+        return false;
+    }
+    mPacing = enabled;
+    mFastFillDuration = fastFillMs;
+    mPacingRate = ratePercent;
+    return true;
+}
+
+void SinkPlayer::SetMultipoint(bool enabled) {
+    mMultipoint = enabled;
+}
+
+void SinkPlayer::SetReadAhead(uint32_t durationMs) {
+    mPacketStreamsMutex->Lock();
+    mReadAheadDuration = durationMs;
+    for (PacketStreamMap::iterator it = mPacketStreams.begin(); it != mPacketStreams.end(); ++it) {
+        it->second->SetReadAhead(mReadAheadDuration);
+    }
+    mPacketStreamsMutex->Unlock();
+    mReadAheadWorker->wakeEvent.SetEvent();
+}
+
+uint32_t SinkPlayer::PacketDurationToFrames(uint32_t ms) {
+    uint64_t frames = NanosToFrames((uint64_t)ms * 1000000, (uint32_t)mDataSource->GetSampleRate());
+    return (uint32_t)MAX((uint64_t)1, MIN(frames, (uint64_t)FRAMES_PER_PACKET));
+}
+
+void SinkPlayer::AddListener(SinkListener* listener) {
+    mSinkListenersMutex->Lock();
+    mSinkListeners.insert(listener);
+    if (!mSinkListenerThread) {
+        mSinkListenerThread = new Thread("SinkListener", &SinkListenerThread);
+        mSinkListenerThread->Start(this);
+    }
+    mSinkListenersMutex->Unlock();
+}
+
+void SinkPlayer::RemoveListener(SinkListener* listener) {
+    mSinkListenersMutex->Lock();
+    SinkListeners::iterator it = mSinkListeners.find(listener);
+    if (it != mSinkListeners.end()) {
+        mSinkListeners.erase(it);
+    }
+    if (mSinkListeners.empty()) {
+        mSinkListenerThread->Stop();
+        mSinkListenerThread->Join();
+        delete mSinkListenerThread;
+        mSinkListenerThread = NULL;
+    }
+    mSinkListenersMutex->Unlock();
+}
+
+struct AddSinkInfo {
+    char* name;
+    SessionPort port;
+    char* path;
+    char* cacheKey;
+    SinkPlayer* sp;
+    AddSinkInfo() : name(NULL), path(NULL), cacheKey(NULL), sp(NULL) { }
+};
+
+bool SinkPlayer::AddSink(const char* name, SessionPort port, const char* path) {
+    return AddSink(name, port, path, NULL, NULL);
+}
+
+bool SinkPlayer::AddSink(const char* name, SessionPort port, const char* path, const char* deviceId, const char* appId) {
+    mSinksMutex->LockShared();
+    bool exists = (LookupSink(name) != NULL);
+    mSinksMutex->UnlockShared();
+    if (exists) {
         QCC_LogError(ER_FAIL, ("AddSink error: already added"));
         return false;
     }
 
-    mAddThreadsMutex->Lock();
-    int count = mAddThreads.count(name);
+    mPendingAddsMutex->Lock();
+    int count = mPendingAdds.count(name);
     if (count > 0) {
         QCC_LogError(ER_FAIL, ("AddSink error: already being added"));
-        mAddThreadsMutex->Unlock();
+        mPendingAddsMutex->Unlock();
         return false;
     }
 
@@ -356,22 +1570,19 @@ bool SinkPlayer::AddSink(const char* name, SessionPort port, const char* path) {
     asi->name = strdup(name);
     asi->path = strdup(path);
     asi->port = port;
+    if (deviceId != NULL && *deviceId && appId != NULL && *appId) {
+        qcc::String cacheKey = qcc::String(deviceId) + " " + appId;
+        asi->cacheKey = strdup(cacheKey.c_str());
+    }
     asi->sp = this;
-    Thread* t = new Thread("AddSink", &AddSinkThread);
-    mAddThreads[name] = t;
-    mAddThreadsMutex->Unlock();
-    t->Start(asi);
+    mPendingAdds.insert(name);
+    mPendingAddsMutex->Unlock();
+    mControlPool->Execute(&AddSinkJob, asi, this);
 
     return true;
 }
 
-struct EmitAudioInfo {
-    SinkInfo* si;
-    SinkPlayer* sp;
-    EmitAudioInfo() : si(NULL), sp(NULL) { }
-};
-
-ThreadReturn SinkPlayer::AddSinkThread(void* arg) {
+ThreadReturn SinkPlayer::AddSinkJob(void* arg) {
     AddSinkInfo* asi = reinterpret_cast<AddSinkInfo*>(arg);
     SinkPlayer* sp = asi->sp;
 
@@ -384,17 +1595,21 @@ ThreadReturn SinkPlayer::AddSinkThread(void* arg) {
             it = sp->mSinkListeners.upper_bound(listener); \
         } \
         sp->mSinkListenersMutex->Unlock(); \
+        sp->mPendingAddsMutex->Lock(); \
+        sp->mPendingAdds.erase(asi->name); \
+        sp->mPendingAddsMutex->Unlock(); \
         sp->FreeSinkInfo(&si); \
         if (asi->name != NULL) { \
             free((void*)asi->name); } \
         if (asi->path != NULL) { \
             free((void*)asi->path); } \
+        if (asi->cacheKey != NULL) { \
+            free((void*)asi->cacheKey); } \
         delete asi; \
         return NULL; \
 }
 
     SinkInfo si;
-    memset(&si, 0, sizeof(si));
 
     QCC_DbgHLPrintf(("Joining session to %s", asi->name));
     SessionId sessionId;
@@ -409,6 +1624,8 @@ ThreadReturn SinkPlayer::AddSinkThread(void* arg) {
 
     si.serviceName = strdup(asi->name);
     si.sessionId = sessionId;
+    si.cacheKey = asi->cacheKey;
+    asi->cacheKey = NULL;
 
     /* Stream interface */
     si.streamObj = new ProxyBusObject(*(sp->mMsgBus), si.serviceName, asi->path, si.sessionId);
@@ -420,16 +1637,25 @@ ThreadReturn SinkPlayer::AddSinkThread(void* arg) {
     si.streamObj->AddInterface(*clockIntf);
 
     sp->mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator sit = find_if(sp->mSinks.begin(), sp->mSinks.end(), FindSink(si.serviceName));
-    if (sit != sp->mSinks.end()) {
-        sp->mSinks.erase(sit);
+    SinkInfo* old = sp->LookupSink(si.serviceName);
+    if (old != NULL) {
+        sp->mSinksBySession.erase(old->sessionId);
+        for (std::list<SinkInfo>::iterator sit = sp->mSinks.begin(); sit != sp->mSinks.end(); ++sit) {
+            if (&(*sit) == old) {
+                sp->mSinks.erase(sit);
+                break;
+            }
+        }
     }
     sp->mSinks.push_back(si);
+    /* List elements never move, so the indexes point straight at them */
+    sp->mSinksByName[si.serviceName] = &sp->mSinks.back();
+    sp->mSinksBySession[si.sessionId] = &sp->mSinks.back();
     sp->mSinksMutex->Unlock();
 
-    sp->mAddThreadsMutex->Lock();
-    sp->mAddThreads.erase(si.serviceName);
-    sp->mAddThreadsMutex->Unlock();
+    sp->mPendingAddsMutex->Lock();
+    sp->mPendingAdds.erase(si.serviceName);
+    sp->mPendingAddsMutex->Unlock();
 
     sp->mSinkListenersMutex->Lock();
     SinkListeners::iterator it = sp->mSinkListeners.begin();
@@ -448,127 +1674,59 @@ ThreadReturn SinkPlayer::AddSinkThread(void* arg) {
 }
 
 bool SinkPlayer::OpenSink(const char* name) {
-    mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-    SinkInfo* si = (it != mSinks.end()) ? &(*it) : NULL;
-    mSinksMutex->Unlock();
+    mSinksMutex->LockShared();
+    SinkInfo* si = LookupSink(name);
+    mSinksMutex->UnlockShared();
     if (!si) {
         QCC_LogError(ER_FAIL, ("OpenSink error: not found"));
         return false;
     }
 
+    QStatus status = OpenSink(si);
+    mSinkCache->Flush();
+    return status == ER_OK;
+}
+
+QStatus SinkPlayer::OpenSink(SinkInfo* si) {
     /* Open the stream */
     Message openReply(*mMsgBus);
     QStatus status = si->streamObj->MethodCall(STREAM_INTERFACE, "Open", NULL, 0, openReply);
     if (status != ER_OK) {
         QCC_LogError(status, ("Stream.Open() failed"));
-        return false;
-    }
-
-    /* Introspect */
-    status = si->streamObj->IntrospectRemoteObject();
-    if (status != ER_OK) {
-        QCC_LogError(status, ("IntrospectRemoteObject(stream) failed"));
-        return false;
-    }
-
-    size_t nChildren = si->streamObj->GetChildren(NULL);
-    if (nChildren == 0) {
-        QCC_LogError(ER_FAIL, ("Stream does not have any child objects"));
-        return false;
-    }
-
-    ProxyBusObject** children = new ProxyBusObject *[nChildren];
-    if (si->streamObj->GetChildren(children, nChildren) != nChildren) {
-        QCC_LogError(ER_FAIL, ("Stream returned bad number of children"));
-        delete[] children;
-        return false;
+        return status;
     }
 
-    for (size_t i = 0; i < nChildren; i++) {
-        ProxyBusObject* child = children[i];
-
-        status = child->IntrospectRemoteObject();
+    /* Find the AudioSink port, skipping introspection if the sink has been seen before */
+    SinkDescriptor descriptor;
+    bool cached = LoadSinkDescriptor(si, descriptor);
+    if (!cached) {
+        status = DiscoverSink(si, descriptor);
         if (status != ER_OK) {
-            QCC_LogError(status, ("IntrospectRemoteObject(child) failed"));
-            break;
-        }
-
-        if (child->ImplementsInterface(AUDIO_SINK_INTERFACE)) {
-            si->portObj = child;
-            break;
+            return status;
         }
     }
 
-    delete[] children;
-
-    if (si->portObj == NULL) {
-        QCC_LogError(ER_FAIL, ("Stream does not have child object that implements AudioSink"));
-        return false;
-    }
-
-    /* Get Capabilities */
-    MsgArg capabilitiesReply;
-    status = si->portObj->GetProperty(PORT_INTERFACE, "Capabilities", capabilitiesReply);
-    if (status == ER_OK) {
-        MSGARG_TO_CAPABILITIES(capabilitiesReply, si->capabilities, si->numCapabilities);
-        //PRINT_CAPABILITIES(si->capabilities, si->numCapabilities);
-    } else {
-        QCC_LogError(status, ("GetProperty(Capabilities) failed"));
-        return false;
-    }
-
-    Capability* capability = NULL;
-    for (size_t i = 0; i < si->numCapabilities; i++) {
-        if (si->capabilities[i].type == mPreferredFormat) {
-            capability = &si->capabilities[i];
-            break;
-        } else if (si->capabilities[i].type == MIMETYPE_AUDIO_RAW) {
-            capability = &si->capabilities[i];
+    status = ConnectSink(si, descriptor);
+    if (status != ER_OK && cached) {
+        /* The sink has changed since it was cached, fall back to full discovery */
+        QCC_LogError(status, ("Cached descriptor of %s is stale", si->serviceName));
+        mSinkCache->Remove(si->cacheKey);
+        si->streamObj->RemoveChild(descriptor.portPath.c_str());
+        si->portObj = NULL;
+        ResetSinkFormat(si);
+
+        descriptor = SinkDescriptor();
+        status = DiscoverSink(si, descriptor);
+        if (status == ER_OK) {
+            status = ConnectSink(si, descriptor);
         }
     }
-
-    if (capability == NULL) {
-        QCC_LogError(ER_FAIL, ("Sink does not even support raw format"));
-        return false;
-    }
-
-    si->encoder = AudioEncoder::Create(capability->type.c_str());
-    si->encoder->Configure(mDataSource);
-    si->selectedCapability = new Capability;
-    si->encoder->GetConfiguration(si->selectedCapability);
-    si->framesPerPacket = si->encoder->GetFrameSize();
-
-    MsgArg connectArgs[3];
-    connectArgs[0].Set("s", ""); // host
-    connectArgs[1].Set("o", "/"); // path
-    Message connectReply(*mMsgBus);
-    CAPABILITY_TO_MSGARG((*si->selectedCapability), connectArgs[2]);
-    status = si->portObj->MethodCall(PORT_INTERFACE, "Connect", connectArgs, 3, connectReply);
-
-    delete [] si->selectedCapability->parameters;
-    si->selectedCapability->parameters = NULL;
-    si->selectedCapability->numParameters = 0;
-
-    if (status == ER_OK) {
-        QCC_DbgTrace(("Port.Connect(%s) success", si->selectedCapability->type.c_str()));
-    } else {
-        QCC_LogError(status, ("Port.Connect() failed"));
-        return false;
+    if (status != ER_OK) {
+        return status;
     }
 
-    /* Get FifoSize */
-    MsgArg fifoSizeReply;
-    status = si->portObj->GetProperty(AUDIO_SINK_INTERFACE, "FifoSize", fifoSizeReply);
-    if (status == ER_OK) {
-        status = fifoSizeReply.Get("u", &si->fifoSize);
-        if (status != ER_OK) {
-            QCC_LogError(status, ("Bad FifoSize property"));
-            return false;
-        }
-    } else {
-        QCC_LogError(status, ("GetProperty(FifoSize) failed"));
-        return false;
+    if (si->cacheKey != NULL) {
+        mSinkCache->Store(si->cacheKey, descriptor);
     }
 
     int64_t diffTime = 0;
@@ -583,10 +1741,11 @@ bool SinkPlayer::OpenSink(const char* name) {
             QCC_DbgTrace(("Port.SetTime(%" PRIu64 ") success", time));
         } else {
             QCC_LogError(status, ("Port.SetTime() failed"));
-            return false;
+            return status;
         }
 
         diffTime = (newTime - time) / 2;
+        AddRttSample(si, newTime - time);
         if (diffTime < 10000000) { // 10ms
             break;
         }
@@ -601,9 +1760,12 @@ bool SinkPlayer::OpenSink(const char* name) {
     status = si->streamObj->MethodCall(CLOCK_INTERFACE, "AdjustTime", adjustTimeArgs, 1, adjustTimeReply);
     if (ER_OK == status) {
         QCC_DbgHLPrintf(("Port.AdjustTime(%" PRId64 ") with %s succeeded", diffTime, si->serviceName));
+        si->statsMutex.Lock();
+        si->stats.clockOffset = diffTime;
+        si->statsMutex.Unlock();
     } else {
         QCC_LogError(status, ("Port.AdjustTime() with %s failed", si->serviceName));
-        return false;
+        return status;
     }
 
     si->fifoPositionHandler = new FifoPositionHandler();
@@ -611,62 +1773,363 @@ bool SinkPlayer::OpenSink(const char* name) {
                                                si->portObj->GetPath().c_str(), si->sessionId);
     if (status != ER_OK) {
         QCC_LogError(status, ("FifoPositionHandler.Register() failed"));
-        return false;
+        return status;
     }
 
+    SeedVolumeCache(si);
+
+    /* Hold the lock until this sink is OPENED so that sinks opened concurrently pick up each other's position */
     mSinksMutex->Lock();
+    /* Prefer a sink sharing the packet stream, its recent packets can be sent to this one as they are */
     SinkInfo* fsi = NULL;
     for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-        if (it->mState == SinkInfo::OPENED) {
+        if (it->mState != SinkInfo::OPENED) {
+            continue;
+        }
+        it->clockMutex.Lock();
+        bool sameStream = (it->packetStream == si->packetStream);
+        it->clockMutex.Unlock();
+        if (fsi == NULL || sameStream) {
             fsi = &(*it);
-            break;
+            if (sameStream) {
+                break;
+            }
         }
     }
     if (!fsi) {
         /* Start from beginning if we're the first sink */
-        si->inputDataBytesRemaining = mDataSource->GetInputSize();
-        si->timestamp = GetCurrentTimeNanos() + 100000000; /* 0.1s */
+        si->inputOffset = 0;
+        si->clock.Set(mDataSource->GetSampleRate(), 0, GetCurrentTimeNanos() + 100000000); /* 0.1s */
     } else {
         /* Start with values from first sink, note these are in the future due to semi-full fifo */
-        fsi->timestampMutex.Lock();
-        si->timestamp = fsi->timestamp;
-        si->inputDataBytesRemaining = fsi->inputDataBytesRemaining;
-        fsi->timestampMutex.Unlock();
+        fsi->clockMutex.Lock();
+        si->clock = fsi->clock;
+        si->inputOffset = fsi->inputOffset;
+        fsi->clockMutex.Unlock();
+
+        /* The first packet sent must still reach the sink before it is due */
+        uint32_t bytesPerFrame = mDataSource->GetBytesPerFrame();
+        uint64_t margin = (si->latencyProfile == LatencyProfile::LOW) ? LOW_LATENCY_START_LEAD_MARGIN : START_LEAD_MARGIN;
+        uint64_t startTime = GetCurrentTimeNanos() + si->rtt + margin;
+        uint64_t framesDiff = 0;
+        if (si->clock.GetTime() > startTime) {
+            framesDiff = NanosToFrames(si->clock.GetTime() - startTime, mDataSource->GetSampleRate());
+        }
+        framesDiff = MIN(framesDiff, si->inputOffset / bytesPerFrame);
+        uint64_t earliest = si->inputOffset - framesDiff * bytesPerFrame;
+
+        /*
+         * Start on a packet the stream still holds, so that it is not encoded
+         * again, or else on the stream's packet grid ending at inputOffset.
+         */
+        uint64_t startOffset = si->packetStream->GetHistoryStart(si->inputOffset, earliest);
+        if (startOffset == si->inputOffset) {
+            uint64_t packetBytes = si->packetStream->GetInputPacketBytes();
+            startOffset -= ((si->inputOffset - earliest) / packetBytes) * packetBytes;
+        }
+        framesDiff = (si->inputOffset - startOffset) / bytesPerFrame;
 
-        uint32_t inputDataBytesAvailable = mDataSource->GetInputSize() - si->inputDataBytesRemaining;
-        uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
-        uint32_t bytesDiff = ((double)(si->timestamp - GetCurrentTimeNanos()) / 1000000000) * bytesPerSecond;
-        bytesDiff = MIN(bytesDiff, inputDataBytesAvailable);
-        bytesDiff = bytesDiff * 0.90; /* Temporary to avoid sending outdated chunks */
-        uint32_t inputPacketBytes = mDataSource->GetBytesPerFrame() * si->framesPerPacket;
-        bytesDiff = bytesDiff - (bytesDiff % inputPacketBytes);
+        /* Rewind so that playback will start sooner on new sink, the shared epoch keeps it in step */
+        si->clock.SetPosition(si->clock.GetPosition() - framesDiff);
+        si->inputOffset = startOffset;
+    }
 
-        /* Adjust values appropriately so that playback will start sooner on new sink */
-        si->timestamp -= (uint64_t)(((double)bytesDiff / bytesPerSecond) * 1000000000);
-        si->inputDataBytesRemaining += bytesDiff;
+    if (mState == PlayerState::PLAYING) {
+        StartEmitting(si);
     }
+
+    si->mState = SinkInfo::OPENED;
     mSinksMutex->Unlock();
 
-    if (mState == PlayerState::PLAYING) {
-        EmitAudioInfo* eai = new EmitAudioInfo;
-        eai->sp = this;
+    return ER_OK;
+}
 
-        mSinksMutex->Lock();
-        std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(si->serviceName));
-        eai->si = &(*it);
-        mSinksMutex->Unlock();
+bool SinkPlayer::LoadSinkDescriptor(SinkInfo* si, SinkDescriptor& descriptor) {
+    if (si->cacheKey == NULL || !mSinkCache->Lookup(si->cacheKey, descriptor)) {
+        return false;
+    }
 
-        mEmitThreadsMutex->Lock();
-        Thread* t = new Thread("EmitAudio", &EmitAudioThread);
-        mEmitThreads[si->serviceName] = t;
-        t->Start(eai);
-        mEmitThreadsMutex->Unlock();
+    if (descriptor.streamPath != si->streamObj->GetPath()) {
+        QCC_DbgHLPrintf(("Cached descriptor of %s is for a different stream", si->serviceName));
+        return false;
     }
 
-    si->mState = SinkInfo::OPENED;
+    ProxyBusObject* portObj = si->streamObj->GetChild(descriptor.portPath.c_str());
+    if (portObj == NULL) {
+        ProxyBusObject child(*mMsgBus, si->serviceName, descriptor.portPath.c_str(), si->sessionId);
+        for (size_t i = 0; i < descriptor.interfaces.size(); i++) {
+            /* Interfaces that aren't defined locally are created from their cached XML */
+            const InterfaceDescription* intf = mMsgBus->GetInterface(descriptor.interfaces[i].c_str());
+            if (intf == NULL && i < descriptor.interfaceXml.size() && !descriptor.interfaceXml[i].empty()) {
+                qcc::String xml = "<node>" + descriptor.interfaceXml[i] + "</node>";
+                QStatus status = mMsgBus->CreateInterfacesFromXml(xml.c_str());
+                if (status == ER_OK) {
+                    intf = mMsgBus->GetInterface(descriptor.interfaces[i].c_str());
+                } else {
+                    QCC_LogError(status, ("Failed to create cached interface %s", descriptor.interfaces[i].c_str()));
+                }
+            }
+            if (intf != NULL) {
+                child.AddInterface(*intf);
+            }
+        }
+        si->streamObj->AddChild(child);
+        portObj = si->streamObj->GetChild(descriptor.portPath.c_str());
+    }
+
+    if (portObj == NULL || !portObj->ImplementsInterface(AUDIO_SINK_INTERFACE)) {
+        return false;
+    }
+    si->portObj = portObj;
+
+    si->numCapabilities = descriptor.capabilities.size();
+    si->capabilities = new Capability[si->numCapabilities];
+    for (size_t i = 0; i < si->numCapabilities; i++) {
+        const CapabilityDescriptor& capability = descriptor.capabilities[i];
+        si->capabilities[i].type = capability.type;
+        si->capabilities[i].numParameters = capability.parameters.size();
+        si->capabilities[i].parameters = new MsgArg[capability.parameters.size()];
+        for (size_t j = 0; j < capability.parameters.size(); j++) {
+            si->capabilities[i].parameters[j] = capability.parameters[j];
+        }
+    }
+
+    QCC_DbgHLPrintf(("Using cached descriptor of %s", si->serviceName));
     return true;
 }
 
+QStatus SinkPlayer::DiscoverSink(SinkInfo* si, SinkDescriptor& descriptor) {
+    /* Introspect */
+    QStatus status = si->streamObj->IntrospectRemoteObject();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("IntrospectRemoteObject(stream) failed"));
+        return status;
+    }
+
+    size_t nChildren = si->streamObj->GetChildren(NULL);
+    if (nChildren == 0) {
+        QCC_LogError(ER_FAIL, ("Stream does not have any child objects"));
+        return ER_FAIL;
+    }
+
+    ProxyBusObject** children = new ProxyBusObject *[nChildren];
+    if (si->streamObj->GetChildren(children, nChildren) != nChildren) {
+        QCC_LogError(ER_FAIL, ("Stream returned bad number of children"));
+        delete[] children;
+        return ER_FAIL;
+    }
+
+    for (size_t i = 0; i < nChildren; i++) {
+        ProxyBusObject* child = children[i];
+
+        status = child->IntrospectRemoteObject();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("IntrospectRemoteObject(child) failed"));
+            break;
+        }
+
+        if (child->ImplementsInterface(AUDIO_SINK_INTERFACE)) {
+            si->portObj = child;
+            break;
+        }
+    }
+
+    delete[] children;
+
+    if (si->portObj == NULL) {
+        QCC_LogError(ER_FAIL, ("Stream does not have child object that implements AudioSink"));
+        return ER_FAIL;
+    }
+
+    /* Get Capabilities */
+    MsgArg capabilitiesReply;
+    status = si->portObj->GetProperty(PORT_INTERFACE, "Capabilities", capabilitiesReply);
+    if (status == ER_OK) {
+        MSGARG_TO_CAPABILITIES(capabilitiesReply, si->capabilities, si->numCapabilities);
+        //PRINT_CAPABILITIES(si->capabilities, si->numCapabilities);
+
+        /* The parameters point into the reply, keep copies that outlive it */
+        for (size_t i = 0; i < si->numCapabilities; i++) {
+            MsgArg* parameters = new MsgArg[si->capabilities[i].numParameters];
+            for (size_t j = 0; j < si->capabilities[i].numParameters; j++) {
+                parameters[j] = si->capabilities[i].parameters[j];
+            }
+            si->capabilities[i].parameters = parameters;
+        }
+    } else {
+        QCC_LogError(status, ("GetProperty(Capabilities) failed"));
+        return status;
+    }
+
+    descriptor.streamPath = si->streamObj->GetPath();
+    descriptor.portPath = si->portObj->GetPath();
+    size_t numInterfaces = si->portObj->GetInterfaces();
+    const InterfaceDescription** interfaces = new const InterfaceDescription *[numInterfaces];
+    numInterfaces = si->portObj->GetInterfaces(interfaces, numInterfaces);
+    for (size_t i = 0; i < numInterfaces; i++) {
+        descriptor.interfaces.push_back(interfaces[i]->GetName());
+        descriptor.interfaceXml.push_back(interfaces[i]->Introspect());
+    }
+    delete[] interfaces;
+    for (size_t i = 0; i < si->numCapabilities; i++) {
+        CapabilityDescriptor capability;
+        capability.type = si->capabilities[i].type;
+        for (size_t j = 0; j < si->capabilities[i].numParameters; j++) {
+            capability.parameters.push_back(si->capabilities[i].parameters[j]);
+        }
+        descriptor.capabilities.push_back(capability);
+    }
+
+    return ER_OK;
+}
+
+QStatus SinkPlayer::ConnectSink(SinkInfo* si, SinkDescriptor& descriptor) {
+    Capability* capability = NULL;
+    for (size_t i = 0; i < si->numCapabilities; i++) {
+        if (si->capabilities[i].type == mPreferredFormat) {
+            capability = &si->capabilities[i];
+            break;
+        } else if (si->capabilities[i].type == MIMETYPE_AUDIO_RAW) {
+            capability = &si->capabilities[i];
+        }
+    }
+
+    if (capability == NULL) {
+        QCC_LogError(ER_FAIL, ("Sink does not even support raw format"));
+        return ER_FAIL;
+    }
+
+    /* Packets must stay well within the shallow FIFO of a low latency sink */
+    bool lowLatency = (mLatencyProfile == LatencyProfile::LOW) && si->portObj->ImplementsInterface(AUDIO_SINK_LATENCY_INTERFACE);
+    uint32_t maxPacketDuration = lowLatency ? MIN(mMaxPacketDuration, (uint32_t)LOW_LATENCY_MAX_PACKET_DURATION) : mMaxPacketDuration;
+    uint32_t minPacketDuration = MIN(mMinPacketDuration, maxPacketDuration);
+    uint32_t framesPerPacket = PacketDurationToFrames(MAX(minPacketDuration, MIN((uint32_t)DEFAULT_PACKET_DURATION, maxPacketDuration)));
+    /* Sinks that came before the Latency interface also came before MaxFramesPerPacket and need full packets */
+    si->fixedPacketSize = !si->portObj->ImplementsInterface(AUDIO_SINK_LATENCY_INTERFACE);
+    if (si->fixedPacketSize) {
+        framesPerPacket = FRAMES_PER_PACKET;
+    }
+    si->packetStream = AcquirePacketStream(capability->type.c_str(), framesPerPacket);
+    si->selectedCapability = new Capability;
+    si->packetStream->GetConfiguration(si->selectedCapability);
+    si->framesPerPacket = si->packetStream->GetFrameSize();
+    si->maxFramesPerPacket = si->fixedPacketSize ? si->framesPerPacket : PacketDurationToFrames(maxPacketDuration);
+
+    /* Raw packets may change size while playing, let the sink know how large they can get */
+    if (capability->type == MIMETYPE_AUDIO_RAW && !si->fixedPacketSize) {
+        AddConfigurationParameter(si->selectedCapability, MAX_FRAMES_PER_PACKET_PARAMETER,
+                                  new MsgArg("u", si->maxFramesPerPacket));
+    }
+
+    /* Sinks without the Latency interface only have the normal profile */
+    if (lowLatency) {
+        AddConfigurationParameter(si->selectedCapability, LATENCY_PROFILE_PARAMETER, new MsgArg("s", LATENCY_PROFILE_LOW));
+    }
+
+    /* Sinks that implement FlowControl push their FIFO level, older sinks ignore the extra parameter */
+    si->creditFlowControl = si->portObj->ImplementsInterface(AUDIO_SINK_FLOW_CONTROL_INTERFACE);
+    if (si->creditFlowControl) {
+        AddConfigurationParameter(si->selectedCapability, FLOW_CONTROL_PARAMETER, new MsgArg("s", FLOW_CONTROL_CREDIT));
+    }
+
+    MsgArg connectArgs[3];
+    connectArgs[0].Set("s", ""); // host
+    connectArgs[1].Set("o", "/"); // path
+    Message connectReply(*mMsgBus);
+    CAPABILITY_TO_MSGARG((*si->selectedCapability), connectArgs[2]);
+    QStatus status = si->portObj->MethodCall(PORT_INTERFACE, "Connect", connectArgs, 3, connectReply);
+
+    delete [] si->selectedCapability->parameters;
+    si->selectedCapability->parameters = NULL;
+    si->selectedCapability->numParameters = 0;
+
+    if (status == ER_OK) {
+        QCC_DbgTrace(("Port.Connect(%s) success", si->selectedCapability->type.c_str()));
+    } else {
+        QCC_LogError(status, ("Port.Connect() failed"));
+        return status;
+    }
+
+    /* The sink may not be able to achieve the low latency profile on its audio device */
+    si->latencyProfile = LatencyProfile::NORMAL;
+    if (lowLatency) {
+        MsgArg latencyProfileReply;
+        char* latencyProfile = NULL;
+        status = si->portObj->GetProperty(AUDIO_SINK_LATENCY_INTERFACE, "LatencyProfile", latencyProfileReply);
+        if (status == ER_OK && latencyProfileReply.Get("s", &latencyProfile) == ER_OK && strcmp(latencyProfile, LATENCY_PROFILE_LOW) == 0) {
+            si->latencyProfile = LatencyProfile::LOW;
+        } else {
+            QCC_LogError(ER_WARNING, ("%s did not achieve the low latency profile", si->serviceName));
+        }
+    }
+
+    /* The sink joins the group's session when it first emits, the FIFO of a low latency sink is too shallow to wait for others */
+    if (mMultipoint && si->latencyProfile == LatencyProfile::NORMAL && si->portObj->ImplementsInterface(AUDIO_SINK_MULTIPOINT_INTERFACE)) {
+        AssignGroup(si);
+    }
+
+    /* Get FifoSize, which depends on the rate and profile the port is connected with, only the normal profile is cached */
+    uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
+    if (!lowLatency && descriptor.fifoSize != 0 && descriptor.fifoType == si->selectedCapability->type &&
+        descriptor.fifoBytesPerSecond == bytesPerSecond) {
+        si->fifoSize = descriptor.fifoSize;
+        return ER_OK;
+    }
+
+    MsgArg fifoSizeReply;
+    status = si->portObj->GetProperty(AUDIO_SINK_INTERFACE, "FifoSize", fifoSizeReply);
+    if (status == ER_OK) {
+        status = fifoSizeReply.Get("u", &si->fifoSize);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Bad FifoSize property"));
+            return status;
+        }
+    } else {
+        QCC_LogError(status, ("GetProperty(FifoSize) failed"));
+        return status;
+    }
+
+    if (lowLatency) {
+        return ER_OK;
+    }
+    descriptor.fifoType = si->selectedCapability->type;
+    descriptor.fifoBytesPerSecond = bytesPerSecond;
+    descriptor.fifoSize = si->fifoSize;
+
+    return ER_OK;
+}
+
+void SinkPlayer::ResetSinkFormat(SinkInfo* si) {
+    LeaveGroup(si);
+
+    if (si->packetStream != NULL) {
+        ReleasePacketStream(si->packetStream);
+        si->packetStream = NULL;
+    }
+
+    if (si->capabilities != NULL) {
+        for (size_t i = 0; i < si->numCapabilities; i++) {
+            delete [] si->capabilities[i].parameters;
+        }
+        delete [] si->capabilities;
+        si->capabilities = NULL;
+        si->numCapabilities = 0;
+    }
+
+    if (si->selectedCapability != NULL) {
+        delete si->selectedCapability;
+        si->selectedCapability = NULL;
+    }
+}
+
+bool SinkPlayer::SetSinkCacheFile(const char* fileName) {
+    return mSinkCache->SetFile(fileName);
+}
+
+void SinkPlayer::ClearSinkCache() {
+    mSinkCache->Clear();
+}
+
 struct RemoveSinkInfo {
     char* name;
     bool lost;
@@ -679,34 +2142,30 @@ bool SinkPlayer::RemoveSink(const char* name) {
 }
 
 bool SinkPlayer::RemoveSink(ajn::SessionId sessionId, bool lost) {
-    mSinksMutex->Lock();
-    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-        SinkInfo* si = &(*it);
-        if (si->sessionId == sessionId) {
-            RemoveSink(si->serviceName, lost);
-            mSinksMutex->Unlock();
-            return true;
-        }
+    mSinksMutex->LockShared();
+    SinkInfo* si = LookupSink(sessionId);
+    if (si != NULL) {
+        RemoveSink(si->serviceName, lost);
     }
-    mSinksMutex->Unlock();
+    mSinksMutex->UnlockShared();
 
-    return false;
+    return si != NULL;
 }
 
 bool SinkPlayer::RemoveSink(const char* name, bool lost) {
-    mSinksMutex->Lock();
-    bool exists = find_if(mSinks.begin(), mSinks.end(), FindSink(name)) != mSinks.end();
-    mSinksMutex->Unlock();
+    mSinksMutex->LockShared();
+    bool exists = (LookupSink(name) != NULL);
+    mSinksMutex->UnlockShared();
     if (!exists) {
         QCC_LogError(ER_FAIL, ("RemoveSink error: not found"));
         return false;
     }
 
-    mRemoveThreadsMutex->Lock();
-    int count = mRemoveThreads.count(name);
+    mPendingRemovesMutex->Lock();
+    int count = mPendingRemoves.count(name);
     if (count > 0) {
         QCC_LogError(ER_FAIL, ("RemoveSink error: already being removed"));
-        mRemoveThreadsMutex->Unlock();
+        mPendingRemovesMutex->Unlock();
         return false;
     }
 
@@ -714,21 +2173,19 @@ bool SinkPlayer::RemoveSink(const char* name, bool lost) {
     rsi->name = strdup(name);
     rsi->lost = lost;
     rsi->sp = this;
-    Thread* t = new Thread("RemoveSink", &RemoveSinkThread);
-    mRemoveThreads[name] = t;
-    mRemoveThreadsMutex->Unlock();
-    t->Start(rsi);
+    mPendingRemoves.insert(name);
+    mPendingRemovesMutex->Unlock();
+    mControlPool->Execute(&RemoveSinkJob, rsi, this);
 
     return true;
 }
 
-ThreadReturn SinkPlayer::RemoveSinkThread(void* arg) {
+ThreadReturn SinkPlayer::RemoveSinkJob(void* arg) {
     RemoveSinkInfo* rsi = reinterpret_cast<RemoveSinkInfo*>(arg);
     SinkPlayer* sp = rsi->sp;
 
     sp->mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(sp->mSinks.begin(), sp->mSinks.end(), FindSink(rsi->name));
-    SinkInfo* si = &(*it);
+    SinkInfo* si = sp->LookupSink(rsi->name);
     QStatus status = sp->CloseSink(si, rsi->lost);
     sp->mSinksMutex->Unlock();
     if (status == ER_OK) {
@@ -747,15 +2204,20 @@ ThreadReturn SinkPlayer::RemoveSinkThread(void* arg) {
     }
 
     sp->mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator sit = find_if(sp->mSinks.begin(), sp->mSinks.end(), FindSink(rsi->name));
-    sp->mSinks.erase(sit);
-    sp->mSinksMutex->Unlock();
-
+    sp->mSinksByName.erase(si->serviceName);
+    sp->mSinksBySession.erase(si->sessionId);
     sp->FreeSinkInfo(si);
+    for (std::list<SinkInfo>::iterator sit = sp->mSinks.begin(); sit != sp->mSinks.end(); ++sit) {
+        if (&(*sit) == si) {
+            sp->mSinks.erase(sit);
+            break;
+        }
+    }
+    sp->mSinksMutex->Unlock();
 
-    sp->mRemoveThreadsMutex->Lock();
-    sp->mRemoveThreads.erase(rsi->name);
-    sp->mRemoveThreadsMutex->Unlock();
+    sp->mPendingRemovesMutex->Lock();
+    sp->mPendingRemoves.erase(rsi->name);
+    sp->mPendingRemovesMutex->Unlock();
 
     sp->mSinkListenersMutex->Lock();
     SinkListeners::iterator lit = sp->mSinkListeners.begin();
@@ -774,13 +2236,12 @@ ThreadReturn SinkPlayer::RemoveSinkThread(void* arg) {
 
 bool SinkPlayer::CloseSink(const char* name) {
     mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-    if (it == mSinks.end()) {
+    SinkInfo* si = LookupSink(name);
+    if (si == NULL) {
         mSinksMutex->Unlock();
         QCC_LogError(ER_FAIL, ("CloseSink error: not found"));
         return false;
     }
-    SinkInfo* si = &(*it);
     QStatus status = CloseSink(si);
     mSinksMutex->Unlock();
     if (status != ER_OK) {
@@ -790,21 +2251,7 @@ bool SinkPlayer::CloseSink(const char* name) {
 }
 
 QStatus SinkPlayer::CloseSink(SinkInfo* si, bool lost) {
-    Thread* t = NULL;
-    mEmitThreadsMutex->Lock();
-    if (mEmitThreads.count(si->serviceName) > 0) {
-        t = mEmitThreads[si->serviceName];
-    }
-    mEmitThreadsMutex->Unlock();
-
-    if (t != NULL) {
-        t->Stop();
-        t->Join();
-    }
-
-    mEmitThreadsMutex->Lock();
-    mEmitThreads.erase(si->serviceName);
-    mEmitThreadsMutex->Unlock();
+    StopEmitting(si);
 
     if (!lost) {
         Message closeReply(*mMsgBus);
@@ -822,32 +2269,33 @@ QStatus SinkPlayer::CloseSink(SinkInfo* si, bool lost) {
         si->fifoPositionHandler = NULL;
     }
 
-    if (si->encoder != NULL) {
-        delete si->encoder;
-        si->encoder = NULL;
-    }
-
-    if (si->capabilities != NULL) {
-        delete [] si->capabilities;
-        si->capabilities = NULL;
-    }
+    ResetSinkFormat(si);
 
-    if (si->selectedCapability != NULL) {
-        delete si->selectedCapability;
-        si->selectedCapability = NULL;
-    }
+    mVolumeCacheMutex->Lock();
+    mVolumeCache.erase(si->sessionId);
+    mVolumeCacheMutex->Unlock();
 
     si->mState = SinkInfo::CLOSED;
     return ER_OK;
 }
 
 bool SinkPlayer::HasSink(const char* name) {
-    mSinksMutex->Lock();
-    bool has = find_if(mSinks.begin(), mSinks.end(), FindSink(name)) != mSinks.end();
-    mSinksMutex->Unlock();
+    mSinksMutex->LockShared();
+    bool has = (LookupSink(name) != NULL);
+    mSinksMutex->UnlockShared();
     return has;
 }
 
+SinkInfo* SinkPlayer::LookupSink(const char* name) {
+    SinkNameIndex::iterator it = mSinksByName.find(name);
+    return (it != mSinksByName.end()) ? it->second : NULL;
+}
+
+SinkInfo* SinkPlayer::LookupSink(SessionId sessionId) {
+    SinkSessionIndex::iterator it = mSinksBySession.find(sessionId);
+    return (it != mSinksBySession.end()) ? it->second : NULL;
+}
+
 bool SinkPlayer::RemoveAllSinks() {
     mSinksMutex->Lock();
     int count = mSinks.size();
@@ -866,453 +2314,1848 @@ bool SinkPlayer::RemoveAllSinks() {
 }
 
 size_t SinkPlayer::GetSinkCount() {
-    mSinksMutex->Lock();
+    mSinksMutex->LockShared();
     int count = mSinks.size();
-    mSinksMutex->Unlock();
+    mSinksMutex->UnlockShared();
     return count;
 }
 
-ThreadReturn SinkPlayer::EmitAudioThread(void* arg) {
-    EmitAudioInfo* eai = reinterpret_cast<EmitAudioInfo*>(arg);
-    Thread* selfThread = Thread::GetThread();
-    SinkPlayer* sp = eai->sp;
-    SinkInfo* si = eai->si;
-    QStatus status = ER_OK;
+void SinkPlayer::StartEmitting(SinkInfo* si) {
+    mEmitTasksMutex->Lock();
+    if (mEmitTasks.count(si->serviceName) > 0) {
+        mEmitTasksMutex->Unlock();
+        return;
+    }
 
-    uint32_t inputPacketBytes = sp->mDataSource->GetBytesPerFrame() * si->framesPerPacket;
-    uint32_t bytesPerSecond = sp->mDataSource->GetSampleRate() * sp->mDataSource->GetBytesPerFrame();
-    uint8_t* readBuffer = (uint8_t*)calloc(inputPacketBytes, 1);
-    uint32_t bytesEmitted = 0;
+    EmitTask* task = new EmitTask;
+    task->sp = this;
+    task->si = si;
+    /* A low latency FIFO is too shallow to be refilled slowly */
+    task->paced = mPacing && si->latencyProfile == LatencyProfile::NORMAL;
+    if (task->paced) {
+        sharedWorkersMutex.Lock();
+        uint32_t slot = sharedWorkers.nextStaggerSlot++ % PACING_STAGGER_SLOTS;
+        sharedWorkersMutex.Unlock();
+        task->stagger = (uint64_t)slot * PACING_STAGGER_INTERVAL * 1000000 / PACING_STAGGER_SLOTS;
+    }
+    mEmitTasks[si->serviceName] = task;
+    si->packetStream->Subscribe(si, si->inputOffset);
+    mReadAheadWorker->wakeEvent.SetEvent();
+
+    /* Give the sink to the least loaded worker */
+    EmitWorker* ew = NULL;
+    size_t minTasks = 0;
+    for (size_t i = 0; i < mEmitWorkers.size(); i++) {
+        mEmitWorkers[i]->mutex.Lock();
+        size_t numTasks = mEmitWorkers[i]->tasks.size();
+        mEmitWorkers[i]->mutex.Unlock();
+        if (ew == NULL || numTasks < minTasks) {
+            ew = mEmitWorkers[i];
+            minTasks = numTasks;
+        }
+    }
+    ew->mutex.Lock();
+    ew->tasks.push_back(task);
+    ew->wakeEvent.SetEvent();
+    ew->mutex.Unlock();
+    mEmitTasksMutex->Unlock();
+}
 
-    while (!selfThread->IsStopping() && si->inputDataBytesRemaining > 0 && (bytesEmitted + inputPacketBytes) <= si->fifoSize) {
-        if (sp->mDataSource->IsDataReady()) {
-            int32_t numBytes = sp->mDataSource->ReadData(readBuffer, sp->mDataSource->GetInputSize() - si->inputDataBytesRemaining, inputPacketBytes);
-            if (numBytes == 0) {            //EOF
-                si->inputDataBytesRemaining = 0;
-                break;
-            }
+void SinkPlayer::StopEmitting(SinkInfo* si) {
+    std::list<SinkInfo*> sinks;
+    sinks.push_back(si);
+    StopEmitting(sinks);
+}
 
-            uint8_t* buffer = readBuffer;
-            uint32_t numBytesToEmit = numBytes;
-            si->encoder->Encode(&buffer, &numBytesToEmit);
+void SinkPlayer::StopEmitting(const std::list<SinkInfo*>& sinks) {
+    /* Stop all the sinks before waiting on any of them */
+    std::list<EmitTask*> tasks;
+    mEmitTasksMutex->Lock();
+    for (std::list<SinkInfo*>::const_iterator sit = sinks.begin(); sit != sinks.end(); ++sit) {
+        std::map<qcc::String, EmitTask*>::iterator it = mEmitTasks.find((*sit)->serviceName);
+        if (it != mEmitTasks.end()) {
+            it->second->stopping = true;
+            tasks.push_back(it->second);
+            mEmitTasks.erase(it);
+        }
+    }
+    mEmitTasksMutex->Unlock();
 
-            sp->mSignallingObject->EmitAudioDataSignal(si->sessionId, buffer, numBytesToEmit, si->timestamp);
+    if (tasks.empty()) {
+        return;
+    }
 
-            si->timestampMutex.Lock();
-            si->timestamp += (uint64_t)(((double)numBytes / bytesPerSecond) * 1000000000);
-            si->inputDataBytesRemaining -= numBytes;
-            si->timestampMutex.Unlock();
+    for (size_t i = 0; i < mEmitWorkers.size(); i++) {
+        mEmitWorkers[i]->wakeEvent.SetEvent();
+    }
+    for (std::list<EmitTask*>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+        Event::Wait((*it)->stopped);
+        delete *it;
+    }
+}
 
-            bytesEmitted += numBytes;
+bool SinkPlayer::IsEmitting(SinkInfo* si) {
+    mEmitTasksMutex->Lock();
+    bool emitting = mEmitTasks.count(si->serviceName) > 0;
+    mEmitTasksMutex->Unlock();
+    return emitting;
+}
 
-            QCC_DbgTrace(("Emitted %i bytes", numBytes));
-        } else {       //Sleep for a few milli sec to wait for data ready again
-            usleep(10 * 1000);
-        }
-    }
+ThreadReturn SinkPlayer::EmitAudioThread(void* arg) {
+    EmitWorker* ew = reinterpret_cast<EmitWorker*>(arg);
+    Thread* selfThread = Thread::GetThread();
 
-    while (!selfThread->IsStopping() && si->inputDataBytesRemaining > 0) {
-        while (!selfThread->IsStopping()) {
-            status = si->fifoPositionHandler->WaitUntilReadyToEmit(50);
-            if (status == ER_OK) {
-                break;
+    while (!selfThread->IsStopping()) {
+        std::vector<Event*> checkEvents;
+        checkEvents.push_back(&selfThread->GetStopEvent());
+        checkEvents.push_back(&ew->wakeEvent);
+        std::list<EmitTask*> ready;
+        uint64_t now = GetCurrentTimeNanos();
+        uint32_t waitMs = Event::WAIT_FOREVER;
+
+        ew->mutex.Lock();
+        ew->wakeEvent.ResetEvent();
+        std::list<EmitTask*>::iterator it = ew->tasks.begin();
+        while (it != ew->tasks.end()) {
+            EmitTask* task = *it;
+            if (task->stopping) {
+                it = ew->tasks.erase(it);
+                task->si->packetStream->Unsubscribe(task->si);
+                task->stopped.SetEvent();
+                continue;
             }
+
+            if (task->retryTime > now) {
+                waitMs = MIN(waitMs, (uint32_t)((task->retryTime - now) / 1000000) + 1);
+            } else if (task->dataReadyEvent != NULL) {
+                /* The sink is served again once the data source has its next packet */
+                if (Event::Wait(*task->dataReadyEvent, 0) == ER_OK) {
+                    ready.push_back(task);
+                } else {
+                    checkEvents.push_back(task->dataReadyEvent);
+                }
+            } else if (!task->filled || task->burstBytes > 0 || task->retryTime != 0) {
+                /* The initial fill and the rest of a refill don't wait for the sink */
+                ready.push_back(task);
+            } else if (task->pacedBytes > 0) {
+                /* The rest of the refill goes out before the FIFO position is read again */
+                if (task->nextEmitTime <= now) {
+                    ready.push_back(task);
+                } else {
+                    waitMs = MIN(waitMs, (uint32_t)((task->nextEmitTime - now) / 1000000) + 1);
+                }
+            } else if (task->si->fifoPositionHandler->WaitUntilReadyToEmit(0) == ER_OK) {
+                ready.push_back(task);
+            } else {
+                checkEvents.push_back(&task->si->fifoPositionHandler->GetReadyToEmitEvent());
+            }
+            ++it;
         }
+        ew->mutex.Unlock();
 
-        if (status != ER_OK) {
-            break;
+        if (ready.empty()) {
+            std::vector<Event*> signaledEvents;
+            Event::Wait(checkEvents, signaledEvents, waitMs);
+            continue;
         }
 
-        // Get FifoPosition, try up to 15 times on timeout
-        MsgArg fifoPositionReply;
-        for (int i = 0; i < 15; i++) {
-            fifoPositionReply.Clear();
-            status = si->portObj->GetProperty(AUDIO_SINK_INTERFACE, "FifoPosition", fifoPositionReply);
-            if (status != ER_TIMEOUT) {
-                break;
+        /* Only this worker removes its tasks, so they stay valid while emitting */
+        for (std::list<EmitTask*>::iterator rit = ready.begin(); rit != ready.end() && !selfThread->IsStopping(); ++rit) {
+            EmitTask* task = *rit;
+            if (task->stopping || task->sp->EmitAudio(task)) {
+                continue;
             }
-            SleepNanos(2 * 1000000000); // 2s
-        }
 
-        if (status != ER_OK) {
-            QCC_LogError(status, ("GetProperty(FifoPosition) failed"));
-            break;
-        }
+            /* Done with this sink until playback is restarted or more is queued */
+            ew->mutex.Lock();
+            ew->tasks.remove(task);
+            task->si->packetStream->Unsubscribe(task->si);
+            task->finished = true;
+            ew->mutex.Unlock();
 
-        uint32_t fifoPosition = 0;
-        status = fifoPositionReply.Get("u", &fifoPosition);
-        if (status != ER_OK) {
-            QCC_LogError(status, ("Bad FifoPosition property"));
-            break;
+            /* StopEmitting deletes the task, and the player may go, as soon as it is stopped */
+            task->sp->CheckEndOfQueue();
+            task->stopped.SetEvent();
         }
+    }
+
+    /* Release any sinks still assigned to this worker */
+    ew->mutex.Lock();
+    for (std::list<EmitTask*>::iterator it = ew->tasks.begin(); it != ew->tasks.end(); ++it) {
+        (*it)->si->packetStream->Unsubscribe((*it)->si);
+        (*it)->stopped.SetEvent();
+    }
+    ew->tasks.clear();
+    ew->mutex.Unlock();
+
+    return 0;
+}
+
+ThreadReturn SinkPlayer::ReadAheadThread(void* arg) {
+    ReadAheadWorker* rw = reinterpret_cast<ReadAheadWorker*>(arg);
+    Thread* selfThread = Thread::GetThread();
+
+    while (!selfThread->IsStopping()) {
+        /* One packet per stream each round, so that a slow stream does not starve the others */
+        rw->mutex.Lock();
+        rw->wakeEvent.ResetEvent();
+        bool encoded = false;
+        for (std::set<PacketStream*>::iterator it = rw->streams.begin(); it != rw->streams.end() && !selfThread->IsStopping(); ++it) {
+            encoded = (*it)->ReadAhead() || encoded;
+        }
+        rw->mutex.Unlock();
+
+        if (!encoded) {
+            /*
+             * Woken when an emitter moves on or a track is queued.  An emitter that runs out of packets waits on the
+             * data source itself, and wakes this once it has read the packet that was not ready.
+             */
+            std::vector<Event*> checkEvents;
+            std::vector<Event*> signaledEvents;
+            checkEvents.push_back(&selfThread->GetStopEvent());
+            checkEvents.push_back(&rw->wakeEvent);
+            Event::Wait(checkEvents, signaledEvents);
+        }
+    }
+
+    return 0;
+}
+
+struct SinkStatsInfo {
+    char* name;
+    SinkStats stats;
+    SinkPlayer* sp;
+    SinkStatsInfo() : name(NULL), sp(NULL) { }
+};
+
+bool SinkPlayer::EmitAudio(EmitTask* task) {
+    SinkInfo* si = task->si;
+    PacketStream* ps = si->packetStream;
+    QStatus status = ER_OK;
+
+    uint32_t inputPacketBytes = ps->GetInputPacketBytes();
+    uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
+    uint32_t bytesToWrite = 0;
+    bool skipOutdated = false;
+    bool refill = false;
+    bool pacedChunk = false;
+    uint32_t fifoPosition = 0;
+    task->retryTime = 0;
+    task->dataReadyEvent = NULL;
+
+    if (!task->filled) {
+        bytesToWrite = si->fifoSize;
+        if (task->paced) {
+            /* Only the fast fill goes out at once, the rest of the FIFO follows at the paced rate */
+            bytesToWrite = MIN(si->fifoSize, (uint32_t)((uint64_t)mFastFillDuration * bytesPerSecond / 1000));
+            StartPacing(task, si->fifoSize - bytesToWrite, inputPacketBytes, 0);
+        }
+        task->filled = true;
+        task->burstBytes = bytesToWrite;
+        task->burstRefill = false;
+    } else if (task->burstBytes > 0) {
+        /* The rest of the fill or refill */
+    } else if (task->pacedBytes > 0) {
+        bytesToWrite = TakePacingTokens(task, inputPacketBytes);
+        skipOutdated = true;
+        pacedChunk = true;
+    } else {
+        if (si->creditFlowControl && si->fifoPositionHandler->GetFifoLevel(fifoPosition, bytesToWrite)) {
+            QCC_DbgTrace(("%d: FifoLevelChanged position %u credit %u", si->sessionId, fifoPosition, bytesToWrite));
+        } else if (si->fifoPositionHandler->GetFifoPosition(status, fifoPosition)) {
+            if (status == ER_TIMEOUT && ++task->retries < FIFO_POSITION_RETRIES) {
+                /* Retry later without holding up the other sinks on this worker */
+                task->retryTime = GetCurrentTimeNanos() + FIFO_POSITION_RETRY_INTERVAL * 1000000ULL;
+                return true;
+            }
+            task->retries = 0;
+
+            if (status != ER_OK) {
+                QCC_LogError(status, ("GetProperty(FifoPosition) failed"));
+                return false;
+            }
+
+            /* A sink may report more than its FIFO size, such as while it still holds a flushed packet */
+            bytesToWrite = (fifoPosition < si->fifoSize) ? si->fifoSize - fifoPosition : 0;
+        } else {
+            /* The worker serves the other sinks until the reply sets the ready to emit event */
+            if (!si->fifoPositionHandler->IsFifoPositionPending()) {
+                status = si->fifoPositionHandler->RequestFifoPosition(si->portObj, FIFO_POSITION_TIMEOUT);
+                if (status != ER_OK) {
+                    QCC_LogError(status, ("GetPropertyAsync(FifoPosition) failed"));
+                    return false;
+                }
+            }
+            return true;
+        }
+        refill = true;
+        if (task->paced) {
+            AdaptPacketSize(task, bytesToWrite, task->refillSkipped);
+            task->refillSkipped = false;
+            StartPacing(task, bytesToWrite, si->packetStream->GetInputPacketBytes(), task->stagger);
+            bytesToWrite = 0;
+        } else {
+            task->burstBytes = bytesToWrite;
+            task->burstRefill = true;
+            task->burstRequested = bytesToWrite;
+        }
+    }
+
+    /* A burst is sent a few packets per turn, so that one sink does not hold up the others on this worker */
+    bool burst = (task->burstBytes > 0);
+    if (burst) {
+        bytesToWrite = MIN(task->burstBytes, (uint32_t)MAX_PACKETS_PER_TURN * inputPacketBytes);
+        skipOutdated = task->burstRefill;
+    }
+
+    uint32_t bytesEmitted = 0;
+    bool skipped = false;
+    SinkStats delta;
+    uint64_t encodeTime = 0;
+    while (!task->stopping && si->inputOffset < mDataSource->GetInputSize64() && (bytesEmitted + inputPacketBytes) <= bytesToWrite) {
+        /* Kept packets, such as the read ahead or a late joiner's prefill, don't wait on the data source */
+        if (!ps->IsCached(si->inputOffset) && !mTrackQueue->IsDataReady(si->inputOffset)) {
+            /* The worker serves the other sinks, and waits on the data source along with their events */
+            task->dataReadyEvent = mTrackQueue->GetDataReadyEvent(si->inputOffset);
+            if (task->dataReadyEvent == NULL) {
+                /* The data source can't signal, so it is checked again later */
+                task->retryTime = GetCurrentTimeNanos() + DATA_READY_POLL_INTERVAL * 1000000ULL;
+            }
+            break;
+        }
+
+        /* Until it joins, the sink is sent its own packets to catch up with the group */
+        bool grouped = false;
+        if (si->group != NULL && JoinGroup(si, grouped)) {
+            /* The sink holds the group where it joins until the reply, the worker serves the other sinks meanwhile */
+            task->retryTime = GetCurrentTimeNanos() + GROUP_JOIN_POLL_INTERVAL * 1000000ULL;
+            break;
+        }
+
+        uint64_t offset = si->inputOffset;
+        EncodedPacket* packet = NULL;
+        if (ps->Acquire(si, offset, &packet) != ER_OK) {            //EOF
+            si->inputOffset = mDataSource->GetInputSize64();
+            break;
+        }
+        uint32_t numBytes = packet->inputSize;
+
+        uint64_t now = GetCurrentTimeNanos();
+        uint64_t timestamp = si->clock.GetTime();
+        if (skipOutdated && timestamp < now) {
+            QCC_LogError(ER_WARNING, ("Skipping emit of audio that's outdated by %" PRIu64 " nanos", now - timestamp));
+            skipped = true;
+            delta.packetsSkipped++;
+        } else {
+            if (!grouped) {
+                mSignallingObject->EmitAudioDataSignal(si->sessionId, packet->data, packet->dataSize, timestamp);
+            }
+            QCC_DbgTrace(("%d: timestamp %" PRIu64 " numBytes %d bytesPerSecond %d", si->sessionId, timestamp, numBytes, bytesPerSecond));
+            bytesEmitted += numBytes;
+            delta.bytesEmitted += packet->dataSize;
+            delta.packetsEmitted++;
+            encodeTime += packet->encodeTime;
+            QCC_DbgTrace(("Emitted %i bytes", numBytes));
+        }
+        ps->Release(si, offset + numBytes);
+
+        si->clockMutex.Lock();
+        si->clock.Advance(numBytes / mDataSource->GetBytesPerFrame());
+        si->inputOffset += numBytes;
+        si->clockMutex.Unlock();
+    }
+
+    if (si->group != NULL) {
+        FlushGroup(si->group);
+    }
+
+    /* Refill what was just sent from the read ahead */
+    if (bytesEmitted > 0 || skipped) {
+        mReadAheadWorker->wakeEvent.SetEvent();
+    }
+
+    task->refillSkipped |= skipped;
+    if (pacedChunk) {
+        SpendPacingTokens(task, bytesEmitted, inputPacketBytes);
+    } else if (burst) {
+        task->burstBytes -= MIN(task->burstBytes, bytesEmitted);
+        if (task->burstBytes < inputPacketBytes) {
+            /* Space that can't take a whole packet is left for the next refill */
+            task->burstBytes = 0;
+            if (task->burstRefill && !task->stopping) {
+                AdaptPacketSize(task, task->burstRequested, task->refillSkipped);
+                task->refillSkipped = false;
+            }
+        }
+    }
+
+    /* Counted once per refill so that the worker takes the lock once */
+    si->statsMutex.Lock();
+    si->stats.bytesEmitted += delta.bytesEmitted;
+    si->stats.packetsEmitted += delta.packetsEmitted;
+    si->stats.packetsSkipped += delta.packetsSkipped;
+    si->encodeTimeTotal += encodeTime;
+    if (refill) {
+        si->stats.fifoRefills++;
+        si->stats.lastFifoPosition = fifoPosition;
+        si->fifoPositionTotal += fifoPosition;
+    }
+    uint64_t now = GetCurrentTimeNanos();
+    bool notify = (now >= si->nextStatsTime);
+    if (notify) {
+        si->nextStatsTime = now + SINK_STATS_INTERVAL;
+    }
+    si->statsMutex.Unlock();
+
+    if (notify) {
+        SinkStatsInfo* ssi = new SinkStatsInfo;
+        ssi->sp = this;
+        ssi->name = strdup(si->serviceName);
+        GetSinkStats(si, ssi->stats);
+        if (mControlPool->Execute(&SinkStatsJob, ssi, this) != ER_OK) {
+            free((void*)ssi->name);
+            delete ssi;
+        }
+
+        /* Once a second is often enough to let go of the tracks every sink has played */
+        if (mTrackQueue->GetTrackCount() > 1) {
+            mControlPool->Execute(&ReleaseTracksJob, this, this);
+        }
+    }
+
+    return si->inputOffset < mDataSource->GetInputSize64();
+}
+
+bool SinkPlayer::GetSinkStats(const char* name, SinkStats& stats) {
+    mSinksMutex->LockShared();
+    SinkInfo* si = LookupSink(name);
+    if (si != NULL) {
+        GetSinkStats(si, stats);
+    }
+    mSinksMutex->UnlockShared();
+    return si != NULL;
+}
+
+void SinkPlayer::GetSinkStats(SinkInfo* si, SinkStats& stats) {
+    si->statsMutex.Lock();
+    stats = si->stats;
+    stats.averageFifoPosition = (stats.fifoRefills > 0) ? (uint32_t)(si->fifoPositionTotal / stats.fifoRefills) : 0;
+    stats.encodeTime = (stats.packetsEmitted > 0) ? si->encodeTimeTotal / stats.packetsEmitted : 0;
+    stats.rtt = si->rtt;
+    si->statsMutex.Unlock();
+}
+
+ThreadReturn SinkPlayer::SinkStatsJob(void* arg) {
+    SinkStatsInfo* ssi = reinterpret_cast<SinkStatsInfo*>(arg);
+    SinkPlayer* sp = ssi->sp;
+
+    sp->mSinkListenersMutex->Lock();
+    SinkListeners::iterator it = sp->mSinkListeners.begin();
+    while (it != sp->mSinkListeners.end()) {
+        SinkListener* listener = *it;
+        listener->SinkStatsChanged(ssi->name, ssi->stats);
+        it = sp->mSinkListeners.upper_bound(listener);
+    }
+    sp->mSinkListenersMutex->Unlock();
+
+    free((void*)ssi->name);
+    delete ssi;
+    return NULL;
+}
+
+ThreadReturn SinkPlayer::ReleaseTracksJob(void* arg) {
+    SinkPlayer* sp = reinterpret_cast<SinkPlayer*>(arg);
+    sp->ReleaseTracks();
+    return NULL;
+}
+
+void SinkPlayer::ReleaseTracks() {
+    std::vector<DataSource*> finished;
+    mSinksMutex->LockShared();
+    bool opened = false;
+    uint64_t offset = DataSource::UNBOUNDED_INPUT_SIZE;
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        if (si->mState != SinkInfo::OPENED) {
+            continue;
+        }
+        opened = true;
+        si->clockMutex.Lock();
+        offset = MIN(offset, si->inputOffset);
+        si->clockMutex.Unlock();
+    }
+
+    /* Keep what a late joiner or the rewind after a Flush may read again */
+    mNextDataSourceMutex->Lock();
+    if (opened && mTrackQueue != NULL) {
+        uint64_t historyBytes = (uint64_t)PACKET_HISTORY_DURATION * mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame() / 1000;
+        if (offset > historyBytes) {
+            mTrackQueue->Release(offset - historyBytes, finished);
+        }
+    }
+    mNextDataSourceMutex->Unlock();
+    mSinksMutex->UnlockShared();
+
+    NotifyDataSourcesFinished(finished);
+}
+
+struct DataSourcesFinishedInfo {
+    SinkPlayer* sp;
+    std::vector<DataSource*> dataSources;
+};
+
+void SinkPlayer::NotifyDataSourcesFinished(const std::vector<DataSource*>& dataSources) {
+    if (dataSources.empty()) {
+        return;
+    }
+
+    DataSourcesFinishedInfo* dsfi = new DataSourcesFinishedInfo;
+    dsfi->sp = this;
+    dsfi->dataSources = dataSources;
+    if (mControlPool->Execute(&DataSourcesFinishedJob, dsfi, this) != ER_OK) {
+        delete dsfi;
+    }
+}
+
+ThreadReturn SinkPlayer::DataSourcesFinishedJob(void* arg) {
+    DataSourcesFinishedInfo* dsfi = reinterpret_cast<DataSourcesFinishedInfo*>(arg);
+    SinkPlayer* sp = dsfi->sp;
+
+    sp->mSinkListenersMutex->Lock();
+    for (size_t i = 0; i < dsfi->dataSources.size(); i++) {
+        SinkListeners::iterator it = sp->mSinkListeners.begin();
+        while (it != sp->mSinkListeners.end()) {
+            SinkListener* listener = *it;
+            listener->DataSourceFinished(dsfi->dataSources[i]);
+            it = sp->mSinkListeners.upper_bound(listener);
+        }
+    }
+    sp->mSinkListenersMutex->Unlock();
+
+    delete dsfi;
+    return NULL;
+}
+
+static uint64_t PacingBucketSize(uint32_t bytesPerSecond, uint32_t inputPacketBytes) {
+    return MAX((uint64_t)inputPacketBytes, (uint64_t)bytesPerSecond * PACING_BURST_DURATION / 1000);
+}
+
+void SinkPlayer::StartPacing(EmitTask* task, uint32_t bytes, uint32_t inputPacketBytes, uint64_t delay) {
+    uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
+    /* Space that can't take a whole packet is left for the next refill */
+    task->pacedBytes = (bytes >= inputPacketBytes) ? bytes : 0;
+    task->nextEmitTime = GetCurrentTimeNanos() + delay;
+    task->tokenTime = task->nextEmitTime;
+    task->tokens = PacingBucketSize(bytesPerSecond, inputPacketBytes);
+}
+
+uint32_t SinkPlayer::TakePacingTokens(EmitTask* task, uint32_t inputPacketBytes) {
+    uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
+    uint64_t rate = (uint64_t)bytesPerSecond * mPacingRate / 100;
+    uint64_t now = GetCurrentTimeNanos();
+    if (now > task->tokenTime) {
+        task->tokens += (now - task->tokenTime) * rate / 1000000000;
+        task->tokenTime = now;
+    }
+    task->tokens = MIN(task->tokens, PacingBucketSize(bytesPerSecond, inputPacketBytes));
+    return (uint32_t)MIN(task->tokens, (uint64_t)task->pacedBytes);
+}
+
+void SinkPlayer::SpendPacingTokens(EmitTask* task, uint32_t bytesEmitted, uint32_t inputPacketBytes) {
+    task->tokens -= MIN(task->tokens, (uint64_t)bytesEmitted);
+    task->pacedBytes -= MIN(task->pacedBytes, bytesEmitted);
+    if (task->pacedBytes < inputPacketBytes) {
+        task->pacedBytes = 0;
+    } else if (task->tokens < inputPacketBytes) {
+        /* Sleep until the bucket holds a whole packet */
+        uint32_t bytesPerSecond = mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame();
+        uint64_t rate = (uint64_t)bytesPerSecond * mPacingRate / 100;
+        task->nextEmitTime = task->tokenTime + (inputPacketBytes - task->tokens) * 1000000000 / rate;
+    }
+}
+
+void SinkPlayer::AssignGroup(SinkInfo* si) {
+    mGroupsMutex->Lock();
+    MultipointGroup* group = NULL;
+    MultipointGroupMap::iterator it = mGroups.find(si->packetStream);
+    if (it != mGroups.end()) {
+        group = it->second;
+    } else {
+        SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, true, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+        SessionPort port = SESSION_PORT_ANY;
+        QStatus status = mMsgBus->BindSessionPort(port, opts, *mMultipointPortListener);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("BindSessionPort for multipoint group failed"));
+            mGroupsMutex->Unlock();
+            return;
+        }
+        group = new MultipointGroup;
+        group->port = port;
+        group->packetStream = AcquirePacketStream(si->packetStream->GetType().c_str(), si->packetStream->GetFrameSize());
+        mGroups[group->packetStream] = group;
+    }
+    group->numSinks++;
+    si->group = group;
+    si->grouped = false;
+    si->groupRefused = false;
+    mGroupsMutex->Unlock();
+}
+
+bool SinkPlayer::JoinGroup(SinkInfo* si, bool& grouped) {
+    MultipointGroup* group = si->group;
+    groupJoinMutex.Lock();
+    group->mutex.Lock();
+    grouped = si->grouped;
+    if (si->groupJoin != NULL || grouped || si->groupRefused) {
+        bool joining = (si->groupJoin != NULL);
+        group->mutex.Unlock();
+        groupJoinMutex.Unlock();
+        return joining;
+    }
+
+    si->clockMutex.Lock();
+    bool first = group->members.empty();
+    bool aligned = first || si->inputOffset == group->inputOffset;
+    if (first) {
+        /* The first member decides where the group is */
+        group->inputOffset = si->inputOffset;
+        group->clock = si->clock;
+        group->packetStream->Subscribe(group, group->inputOffset);
+    }
+    si->clockMutex.Unlock();
+    if (!aligned) {
+        group->mutex.Unlock();
+        groupJoinMutex.Unlock();
+        return false;
+    }
+
+    /* As a member the sink holds the group at its offset until it has joined */
+    group->members.insert(si);
+    GroupJoin* join = new GroupJoin;
+    join->si = si;
+    join->group = group;
+    si->groupJoin = join;
+    group->mutex.Unlock();
+    groupJoinMutex.Unlock();
+
+    MsgArg joinArg("q", group->port);
+    QStatus status = si->portObj->MethodCallAsync(AUDIO_SINK_MULTIPOINT_INTERFACE, "Join",
+                                                  this, static_cast<MessageReceiver::ReplyHandler>(&SinkPlayer::JoinReplyHandler),
+                                                  &joinArg, 1, join);
+    if (status != ER_OK) {
+        FinishJoin(join, status, 0, "");
+    }
+    return true;
+}
+
+void SinkPlayer::JoinReplyHandler(Message& msg, void* context) {
+    GroupJoin* join = reinterpret_cast<GroupJoin*>(context);
+
+    SessionId sessionId = 0;
+    QStatus status = ER_OK;
+    if (msg->GetType() != MESSAGE_METHOD_RET) {
+        status = ER_BUS_REPLY_IS_ERROR_MESSAGE;
+    } else {
+        const MsgArg* sessionIdArg = msg->GetArg(0);
+        status = (sessionIdArg != NULL) ? sessionIdArg->Get("u", &sessionId) : ER_BAD_ARG_COUNT;
+    }
+    FinishJoin(join, status, sessionId, msg->GetSender());
+}
+
+void SinkPlayer::FinishJoin(GroupJoin* join, QStatus status, SessionId sessionId, const qcc::String& memberName) {
+    bool remove = false;
+    groupJoinMutex.Lock();
+    SinkInfo* si = join->si;
+    if (si != NULL) {
+        MultipointGroup* group = join->group;
+        group->mutex.Lock();
+        si->groupJoin = NULL;
+        /* The session ends when its last member leaves, so the first to join may have started a new one */
+        bool alone = true;
+        for (std::set<SinkInfo*>::iterator it = group->members.begin(); it != group->members.end(); ++it) {
+            alone = alone && !(*it)->grouped;
+        }
+        /* A sink that fell behind while joining was dropped from the members by FlushGroup */
+        bool member = (group->members.count(si) > 0);
+        if (status == ER_OK && alone && member) {
+            group->sessionId = sessionId;
+        }
+        if (status == ER_OK && member && sessionId == group->sessionId) {
+            QCC_DbgHLPrintf(("%s joined multipoint session %u", si->serviceName, sessionId));
+            si->grouped = true;
+            si->memberName = memberName;
+        } else {
+            QCC_LogError((status != ER_OK) ? status : ER_FAIL, ("%s failed to join multipoint session", si->serviceName));
+            group->members.erase(si);
+            si->groupRefused = true;
+            remove = (status == ER_OK && sessionId == group->sessionId);
+        }
+        group->mutex.Unlock();
+    }
+    groupJoinMutex.Unlock();
+    delete join;
+
+    if (remove) {
+        /* Sent its own packets from now on, so it must not get the group's too */
+        mMsgBus->EnableConcurrentCallbacks();
+        status = mMsgBus->RemoveSessionMember(sessionId, memberName);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("RemoveSessionMember failed"));
+        }
+    }
+}
+
+void SinkPlayer::LeaveGroup(SinkInfo* si) {
+    MultipointGroup* group = si->group;
+    if (group == NULL) {
+        return;
+    }
+
+    /* The sink itself leaves the session when its stream is closed */
+    groupJoinMutex.Lock();
+    group->mutex.Lock();
+    group->members.erase(si);
+    if (si->groupJoin != NULL) {
+        si->groupJoin->si = NULL;
+        si->groupJoin = NULL;
+    }
+    group->mutex.Unlock();
+    groupJoinMutex.Unlock();
+    si->group = NULL;
+    si->grouped = false;
+    si->groupRefused = false;
+
+    mGroupsMutex->Lock();
+    if (--group->numSinks == 0) {
+        mGroups.erase(group->packetStream);
+        mMsgBus->UnbindSessionPort(group->port);
+        group->packetStream->Unsubscribe(group);
+        ReleasePacketStream(group->packetStream);
+        delete group;
+    }
+    mGroupsMutex->Unlock();
+}
+
+void SinkPlayer::FlushGroup(MultipointGroup* group) {
+    group->mutex.Lock();
+    if (group->members.empty()) {
+        group->mutex.Unlock();
+        return;
+    }
+
+    std::map<SinkInfo*, uint64_t> inputOffsets;
+    uint64_t leadOffset = 0;
+    for (std::set<SinkInfo*>::iterator it = group->members.begin(); it != group->members.end(); ++it) {
+        (*it)->clockMutex.Lock();
+        uint64_t inputOffset = (*it)->inputOffset;
+        (*it)->clockMutex.Unlock();
+        inputOffsets[*it] = inputOffset;
+        leadOffset = MAX(leadOffset, inputOffset);
+    }
+
+    /* A member that has fallen far behind would hold up the rest, so it is sent its own packets instead */
+    uint64_t maxLag = (uint64_t)PacketDurationToFrames(MAX_GROUP_LAG) * mDataSource->GetBytesPerFrame();
+    std::vector<qcc::String> evicted;
+    for (std::set<SinkInfo*>::iterator it = group->members.begin(); it != group->members.end();) {
+        SinkInfo* si = *it;
+        if (inputOffsets[si] + maxLag >= leadOffset) {
+            ++it;
+            continue;
+        }
+        QCC_LogError(ER_WARNING, ("%s fell %" PRIu64 " bytes behind its multipoint group, leaving it", si->serviceName, leadOffset - inputOffsets[si]));
+        if (si->grouped) {
+            evicted.push_back(si->memberName);
+        }
+        si->grouped = false;
+        si->groupRefused = true;
+        group->members.erase(it++);
+    }
+
+    /* Signal what every member has taken in */
+    uint64_t endOffset = leadOffset;
+    for (std::set<SinkInfo*>::iterator it = group->members.begin(); it != group->members.end(); ++it) {
+        endOffset = MIN(endOffset, inputOffsets[*it]);
+    }
+
+    PacketStream* ps = group->packetStream;
+    uint64_t packetsSkipped = 0;
+    while (group->inputOffset < endOffset) {
+        uint64_t offset = group->inputOffset;
+        EncodedPacket* packet = NULL;
+        if (ps->Acquire(group, offset, &packet) != ER_OK) {
+            break;
+        }
+
+        uint64_t timestamp = group->clock.GetTime();
+        if (timestamp >= GetCurrentTimeNanos()) {
+            mSignallingObject->EmitAudioDataSignal(group->sessionId, packet->data, packet->dataSize, timestamp);
+        } else {
+            packetsSkipped++;
+        }
+        ps->Release(group, offset + packet->inputSize);
+        group->clock.Advance(packet->inputSize / mDataSource->GetBytesPerFrame());
+        group->inputOffset += packet->inputSize;
+    }
+
+    if (packetsSkipped > 0) {
+        QCC_LogError(ER_WARNING, ("Skipped %" PRIu64 " outdated packets of multipoint session %u", packetsSkipped, group->sessionId));
+        /* Every member missed them */
+        for (std::set<SinkInfo*>::iterator it = group->members.begin(); it != group->members.end(); ++it) {
+            (*it)->statsMutex.Lock();
+            (*it)->stats.packetsSkipped += packetsSkipped;
+            (*it)->statsMutex.Unlock();
+        }
+    }
+    SessionId sessionId = group->sessionId;
+    group->mutex.Unlock();
+
+    for (size_t i = 0; i < evicted.size(); i++) {
+        QStatus status = mMsgBus->RemoveSessionMember(sessionId, evicted[i]);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("RemoveSessionMember failed"));
+        }
+    }
+}
+
+void SinkPlayer::ResetGroups() {
+    /* Play and Seek move every sink to the same place, so any member can lead the group there */
+    mGroupsMutex->Lock();
+    for (MultipointGroupMap::iterator it = mGroups.begin(); it != mGroups.end(); ++it) {
+        MultipointGroup* group = it->second;
+        group->mutex.Lock();
+        if (!group->members.empty()) {
+            SinkInfo* si = *group->members.begin();
+            si->clockMutex.Lock();
+            group->inputOffset = si->inputOffset;
+            group->clock = si->clock;
+            si->clockMutex.Unlock();
+            group->packetStream->Subscribe(group, group->inputOffset);
+        }
+        group->mutex.Unlock();
+    }
+    mGroupsMutex->Unlock();
+}
+
+void SinkPlayer::AdaptPacketSize(EmitTask* task, uint32_t bytesRequested, bool skipped) {
+    SinkInfo* si = task->si;
+    if (si->packetStream->GetType() != MIMETYPE_AUDIO_RAW) {
+        /* The packet size of other formats is fixed by Connect */
+        return;
+    }
+    if (si->group != NULL || si->fixedPacketSize) {
+        /* The members of a group share packets, and older sinks only take full ones */
+        return;
+    }
+
+    uint32_t framesPerPacket = si->framesPerPacket;
+    if (skipped || bytesRequested >= (si->fifoSize / 4) * 3) {
+        /* The FIFO is running dry, spend less on per packet overhead */
+        framesPerPacket *= 2;
+        task->healthyBursts = 0;
+    } else if (++task->healthyBursts >= PACKET_SHRINK_BURSTS) {
+        framesPerPacket /= 2;
+        task->healthyBursts = 0;
+    } else {
+        return;
+    }
+
+    /* Commands take a round trip anyway, so packets shorter than that don't make pause or late join any finer */
+    uint32_t minFrames = PacketDurationToFrames(mMinPacketDuration);
+    minFrames = MAX(minFrames, (uint32_t)MIN(NanosToFrames(si->rtt, (uint32_t)mDataSource->GetSampleRate()), (uint64_t)FRAMES_PER_PACKET));
+    uint32_t maxFrames = si->maxFramesPerPacket;
+    framesPerPacket = MIN(MAX(framesPerPacket, MIN(minFrames, maxFrames)), maxFrames);
+    if (framesPerPacket == si->framesPerPacket) {
+        return;
+    }
+
+    QCC_DbgHLPrintf(("%s: packet size %u -> %u frames", si->serviceName, si->framesPerPacket, framesPerPacket));
+    /* Only this emitter changes inputOffset and packetStream while it runs, others read them under clockMutex */
+    uint64_t offset = si->inputOffset;
+    PacketStream* ps = AcquirePacketStream(MIMETYPE_AUDIO_RAW, framesPerPacket);
+    ps->Subscribe(si, offset);
+    PacketStream* oldPs = si->packetStream;
+    si->clockMutex.Lock();
+    si->packetStream = ps;
+    si->framesPerPacket = framesPerPacket;
+    si->clockMutex.Unlock();
+    oldPs->Unsubscribe(si);
+    ReleasePacketStream(oldPs);
+}
+
+bool SinkPlayer::OpenAllSinks() {
+    mSinksMutex->LockShared();
+    int count = mSinks.size();
+    mSinksMutex->UnlockShared();
+    if (count == 0) {
+        return false;
+    }
+
+    OpenAllSinks(0);
+    return true;
+}
+
+struct OpenSinkInfo {
+    char* name;
+    SinkPlayer* sp;
+    QStatus status;
+    bool abandoned;
+    Event done;
+    OpenSinkInfo() : name(NULL), sp(NULL), status(ER_TIMEOUT), abandoned(false) { }
+};
+
+bool SinkPlayer::OpenAllSinks(uint32_t timeout, OpenSinkResults* results) {
+    std::list<qcc::String> names;
+    mSinksMutex->LockShared();
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        names.push_back(it->serviceName);
+    }
+    mSinksMutex->UnlockShared();
+
+    if (names.empty()) {
+        return false;
+    }
+
+    /* Run the open sequence of every sink concurrently */
+    std::list<OpenSinkInfo*> osis;
+    bool success = true;
+    mPendingOpensMutex->Lock();
+    for (std::list<qcc::String>::iterator it = names.begin(); it != names.end(); ++it) {
+        if (mPendingOpens.count(*it) > 0) {
+            QCC_LogError(ER_BUSY, ("OpenAllSinks: %s is still being opened", it->c_str()));
+            if (results != NULL) {
+                (*results)[*it] = ER_BUSY;
+            }
+            success = false;
+            continue;
+        }
+
+        OpenSinkInfo* osi = new OpenSinkInfo;
+        osi->name = strdup(it->c_str());
+        osi->sp = this;
+        mPendingOpens.insert(*it);
+        osis.push_back(osi);
+        mControlPool->Execute(&OpenSinkJob, osi, this);
+    }
+    mPendingOpensMutex->Unlock();
+
+    uint64_t deadline = GetCurrentTimeNanos() + (uint64_t)timeout * 1000000;
+    for (std::list<OpenSinkInfo*>::iterator it = osis.begin(); it != osis.end(); ++it) {
+        uint32_t waitMs = Event::WAIT_FOREVER;
+        if (timeout != 0) {
+            uint64_t now = GetCurrentTimeNanos();
+            waitMs = (now < deadline) ? (uint32_t)((deadline - now) / 1000000) : 0;
+        }
+        Event::Wait((*it)->done, waitMs);
+    }
+
+    /* Collect the results, sinks that missed the deadline finish in the background */
+    mPendingOpensMutex->Lock();
+    for (std::list<OpenSinkInfo*>::iterator it = osis.begin(); it != osis.end(); ++it) {
+        OpenSinkInfo* osi = *it;
+        if (results != NULL) {
+            (*results)[osi->name] = osi->status;
+        }
+        if (osi->status != ER_OK) {
+            success = false;
+        }
+
+        if (osi->done.IsSet()) {
+            mPendingOpens.erase(osi->name);
+            free((void*)osi->name);
+            delete osi;
+        } else {
+            QCC_LogError(ER_TIMEOUT, ("OpenAllSinks: %s did not open before the deadline", osi->name));
+            osi->abandoned = true;
+        }
+    }
+    mPendingOpensMutex->Unlock();
+
+    /* Written once for all the sinks opened */
+    mSinkCache->Flush();
+
+    return success;
+}
+
+ThreadReturn SinkPlayer::OpenSinkJob(void* arg) {
+    OpenSinkInfo* osi = reinterpret_cast<OpenSinkInfo*>(arg);
+    SinkPlayer* sp = osi->sp;
+
+    sp->mSinksMutex->LockShared();
+    SinkInfo* si = sp->LookupSink(osi->name);
+    sp->mSinksMutex->UnlockShared();
+
+    QStatus status = ER_FAIL;
+    if (si != NULL) {
+        status = sp->OpenSink(si);
+    } else {
+        QCC_LogError(status, ("OpenSink error: not found"));
+    }
+
+    sp->mPendingOpensMutex->Lock();
+    bool abandoned = osi->abandoned;
+    if (abandoned) {
+        /* OpenAllSinks has already returned */
+        sp->mPendingOpens.erase(osi->name);
+        free((void*)osi->name);
+        delete osi;
+    } else {
+        osi->status = status;
+        osi->done.SetEvent();
+    }
+    sp->mPendingOpensMutex->Unlock();
+
+    if (abandoned) {
+        sp->mSinkCache->Flush();
+    }
+
+    return NULL;
+}
+
+bool SinkPlayer::CloseAllSinks() {
+    mSinksMutex->Lock();
+    int count = mSinks.size();
+    if (count == 0) {
+        mSinksMutex->Unlock();
+        return false;
+    }
+
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        CloseSink(si->serviceName);
+    }
+
+    mSinksMutex->Unlock();
+
+    return true;
+}
+
+bool SinkPlayer::IsPlaying() {
+    return mState == PlayerState::PLAYING;
+}
+
+bool SinkPlayer::Play() {
+    Play(NULL);
+    return true;
+}
+
+bool SinkPlayer::Play(SinkResults* results) {
+    if (mState == PlayerState::PLAYING) {
+        if (results != NULL) {
+            results->clear();
+        }
+        return true;
+    }
+
+    GroupCall group;
+    mSinksMutex->Lock();
+    bool first = true;
+    uint64_t inputOffset = 0;
+    StartLead startLead = ComputeStartLead();
+    QCC_DbgHLPrintf(("Play lead %" PRIu64 " nanos (rtt %" PRIu64 " from %s, fill %" PRIu64 ", buffer %" PRIu64 ")", startLead.lead, startLead.worstRtt,
+                      startLead.worstSink.c_str(), startLead.fillTime, startLead.bufferTime));
+    uint64_t timestamp = GetCurrentTimeNanos() + startLead.lead + startLead.bufferTime;
+    std::list<SinkInfo*> sinks;
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        if (si->mState == SinkInfo::OPENED && !IsEmitting(si)) {
+            CallSinkAsync(&group, si, AUDIO_SINK_INTERFACE, "Play", NULL, 0);
+
+            if (first) {
+                // Save value from first sink
+                inputOffset = si->inputOffset;
+                first = false;
+            } else {
+                // Apply to all other sinks
+                si->inputOffset = inputOffset;
+            }
+            uint64_t position = si->inputOffset / mDataSource->GetBytesPerFrame();
+            si->clock.Set(mDataSource->GetSampleRate(), position, timestamp);
+            sinks.push_back(si);
+        }
+    }
+
+    /* Every sink is in place before any of them emits for its group */
+    ResetGroups();
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        StartEmitting(*it);
+    }
+    mSinksMutex->Unlock();
+
+    mState = PlayerState::PLAYING;
+
+    bool success = group.Wait(results);
+    UpdateRtts(&group);
+
+    uint64_t now = GetCurrentTimeNanos();
+    if (now > timestamp) {
+        QCC_DbgHLPrintf(("Play calls finished after timestamp by %" PRIu64 " nanos", now - timestamp));
+    }
+
+    return success;
+}
+
+bool SinkPlayer::Pause() {
+    Pause(NULL);
+    return true;
+}
+
+bool SinkPlayer::Pause(SinkResults* results) {
+    if (mState != PlayerState::PLAYING) {
+        if (results != NULL) {
+            results->clear();
+        }
+        return true;
+    }
+
+    GroupCall group;
+    std::list<SinkInfo*> sinks;
+    mSinksMutex->Lock();
+    StartLead startLead = ComputeStartLead();
+    QCC_DbgHLPrintf(("Pause lead %" PRIu64 " nanos (rtt %" PRIu64 " from %s)", startLead.lead, startLead.worstRtt, startLead.worstSink.c_str()));
+    uint64_t pauseTimeNanos = GetCurrentTimeNanos() + startLead.lead;
+    uint64_t flushTimeNanos = pauseTimeNanos + 1000000;
+    MsgArg pauseArgs("t", pauseTimeNanos);
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        if (si->mState == SinkInfo::OPENED && IsEmitting(si)) {
+            CallSinkAsync(&group, si, AUDIO_SINK_INTERFACE, "Pause", &pauseArgs, 1);
+            sinks.push_back(si);
+        }
+    }
+
+    StopEmitting(sinks);
+
+    /* Flush only after the emitters have stopped so that nothing is sent after it */
+    MsgArg flushArgs("t", flushTimeNanos);
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        SinkInfo* si = *it;
+        FlushCall* flush = new FlushCall;
+        flush->sp = this;
+        flush->name = si->serviceName;
+        si->clockMutex.Lock();
+        flush->generation = si->flushGeneration;
+        si->clockMutex.Unlock();
+        QStatus status = si->portObj->MethodCallAsync(AUDIO_SINK_INTERFACE, "Flush",
+                                                      this, static_cast<MessageReceiver::ReplyHandler>(&SinkPlayer::FlushReplyHandler),
+                                                      &flushArgs, 1, flush);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Flush error"));
+            delete flush;
+        }
+    }
+    mSinksMutex->Unlock();
+
+    mState = PlayerState::PAUSED;
+
+    bool success = group.Wait(results);
+    UpdateRtts(&group);
+
+    uint64_t now = GetCurrentTimeNanos();
+    if (now > pauseTimeNanos) {
+        QCC_DbgHLPrintf(("Pause calls finished after timestamp by %" PRIu64 " nanos", now - pauseTimeNanos));
+    }
+
+    return success;
+}
+
+bool SinkPlayer::Seek(uint64_t positionNanos, SinkResults* results) {
+    if (mState == PlayerState::IDLE) {
+        QCC_LogError(ER_FAIL, ("Seek without a data source"));
+        return false;
+    }
+
+    if (!mDataSource->IsSeekable()) {
+        QCC_LogError(ER_FAIL, ("Seek in a data source that can only be read in order"));
+        return false;
+    }
+
+    uint32_t bytesPerFrame = mDataSource->GetBytesPerFrame();
+    uint64_t inputSize = mDataSource->GetInputSize64();
+    uint64_t offset = NanosToFrames(positionNanos, mDataSource->GetSampleRate()) * bytesPerFrame;
+    offset = MIN(offset, inputSize - (inputSize % bytesPerFrame));
+    /* Tracks that have been played and released can't be returned to */
+    offset = MAX(offset, mTrackQueue->GetStart());
+
+    bool playing = (mState == PlayerState::PLAYING);
+    GroupCall group;
+    std::list<SinkInfo*> sinks;
+    mSinksMutex->Lock();
+    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+        SinkInfo* si = &(*it);
+        if (si->mState == SinkInfo::OPENED) {
+            sinks.push_back(si);
+        }
+    }
+
+    StopEmitting(sinks);
+
+    /* Cut every sink at the same instant, a paused sink has nothing left to present */
+    StartLead startLead = ComputeStartLead();
+    uint64_t flushTimeNanos = playing ? (GetCurrentTimeNanos() + startLead.lead) : 0;
+    MsgArg flushArgs("t", flushTimeNanos);
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        CallSinkAsync(&group, *it, AUDIO_SINK_INTERFACE, "Flush", &flushArgs, 1);
+        if (playing) {
+            /* The Flush leaves the sink idle, so it is primed again to present the new audio as soon as it lands */
+            CallSinkAsync(&group, *it, AUDIO_SINK_INTERFACE, "Play", NULL, 0);
+        }
+    }
+
+    /*
+     * A sink handles the messages from this player in order, and its Flush handler holds back the rest until
+     * flushTimeNanos, so the new audio can be sent now without being flushed.  It only has to be filled by then.
+     */
+    uint64_t timestamp = flushTimeNanos + startLead.fillTime + startLead.margin;
+    QCC_DbgHLPrintf(("Seek to %" PRIu64 " nanos, restarting at %" PRIu64, positionNanos, timestamp));
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        SinkInfo* si = *it;
+        si->clockMutex.Lock();
+        si->inputOffset = offset;
+        si->clock.Set(mDataSource->GetSampleRate(), offset / bytesPerFrame, timestamp);
+        /* A Flush reply still to come from an earlier Pause no longer applies to inputOffset */
+        si->flushGeneration++;
+        si->clockMutex.Unlock();
+    }
+
+    /* Every sink is in place before any of them emits for its group */
+    ResetGroups();
+    if (playing) {
+        for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+            StartEmitting(*it);
+        }
+    }
+    mSinksMutex->Unlock();
 
-        bytesEmitted = 0;
-        uint32_t bytesToWrite = si->fifoSize - fifoPosition;
+    /* The replies to a timed Flush wait for it, so they are no measure of the round trip time */
+    bool success = group.Wait(results);
+    if (!playing) {
+        UpdateRtts(&group);
+    }
 
-        while (!selfThread->IsStopping() && si->inputDataBytesRemaining > 0 && (bytesEmitted + inputPacketBytes) <= bytesToWrite) {
-            if (sp->mDataSource->IsDataReady()) {
-                int32_t numBytes = sp->mDataSource->ReadData(readBuffer, sp->mDataSource->GetInputSize() - si->inputDataBytesRemaining, inputPacketBytes);
-                if (numBytes == 0) {                //EOF
-                    si->inputDataBytesRemaining = 0;
-                    break;
-                }
+    return success;
+}
 
-                uint8_t* buffer = readBuffer;
-                uint32_t numBytesToEmit = numBytes;
-                si->encoder->Encode(&buffer, &numBytesToEmit);
+void SinkPlayer::CallSinkAsync(GroupCall* group, SinkInfo* si, const char* iface, const char* method, const MsgArg* args, size_t numArgs) {
+    group->Hold();
+
+    GroupCallContext* ctx = new GroupCallContext;
+    ctx->group = group;
+    ctx->name = si->serviceName;
+    ctx->method = method;
+    ctx->sendTime = GetCurrentTimeNanos();
+    QStatus status = si->portObj->MethodCallAsync(iface, method,
+                                                  this, static_cast<MessageReceiver::ReplyHandler>(&SinkPlayer::GroupCallReplyHandler),
+                                                  args, numArgs, ctx);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("%s error", method));
+        group->Complete(ctx->name, status);
+        delete ctx;
+    }
+}
 
-                uint64_t now = GetCurrentTimeNanos();
-                if (si->timestamp < now) {
-                    QCC_LogError(ER_WARNING, ("Skipping emit of audio that's outdated by %" PRIu64 " nanos", now - si->timestamp));
-                } else {
-                    sp->mSignallingObject->EmitAudioDataSignal(si->sessionId, buffer, numBytesToEmit, si->timestamp);
-                    QCC_DbgTrace(("%d: timestamp %" PRIu64 " numBytes %d bytesPerSecond %d", si->sessionId, si->timestamp, numBytes, bytesPerSecond));
-                    bytesEmitted += numBytes;
-                    QCC_DbgTrace(("Emitted %i bytes", numBytes));
-                }
+void SinkPlayer::GroupCallReplyHandler(Message& msg, void* context) {
+    GroupCallContext* ctx = reinterpret_cast<GroupCallContext*>(context);
 
-                si->timestampMutex.Lock();
-                si->timestamp += (uint64_t)(((double)numBytes / bytesPerSecond) * 1000000000);
-                si->inputDataBytesRemaining -= numBytes;
-                si->timestampMutex.Unlock();
-            } else {           //Sleep for a few milli sec to wait for data ready again
-                usleep(10 * 1000);
-            }
-        }
+    QStatus status = ER_OK;
+    uint64_t rtt = GetCurrentTimeNanos() - ctx->sendTime;
+    const MsgArg* value = NULL;
+    if (msg->GetType() != MESSAGE_METHOD_RET) {
+        rtt = 0; /* Includes the reply timeout */
+        status = ER_BUS_REPLY_IS_ERROR_MESSAGE;
+        qcc::String errorMessage;
+        QCC_LogError(status, ("%s error from %s: %s", ctx->method, ctx->name.c_str(), msg->GetErrorName(&errorMessage)));
+    } else {
+        value = msg->GetArg(0);
     }
 
-    return 0;
+    /* Every call gets a reply, if only a timeout error, so the group outlives its contexts */
+    GroupCall* group = ctx->group;
+    VolumeCallInfo* vci = group->volumeCall; /* Read first, a waiting sender may free its group once complete */
+    if (group->Complete(ctx->name, status, rtt, value) && vci != NULL) {
+        FinishVolumeCall(group);
+    }
+    delete ctx;
 }
 
-bool SinkPlayer::OpenAllSinks() {
+void SinkPlayer::UpdateRtts(GroupCall* group) {
     mSinksMutex->Lock();
-    int count = mSinks.size();
-    if (count == 0) {
-        mSinksMutex->Unlock();
-        return false;
+    for (std::map<qcc::String, uint64_t>::iterator it = group->rtts.begin(); it != group->rtts.end(); ++it) {
+        SinkInfo* si = LookupSink(it->first.c_str());
+        if (si != NULL) {
+            AddRttSample(si, it->second);
+        }
     }
+    mSinksMutex->Unlock();
+}
 
+StartLead SinkPlayer::ComputeStartLead() {
+    StartLead startLead;
+    bool lowLatency = (mLatencyProfile == LatencyProfile::LOW);
+    uint64_t emitTime = 0;
+    size_t numSinks = 0;
+    uint32_t maxFifoSize = 0;
     for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
         SinkInfo* si = &(*it);
-        OpenSink(si->serviceName);
+        if (si->mState != SinkInfo::OPENED) {
+            continue;
+        }
+        maxFifoSize = MAX(maxFifoSize, si->fifoSize);
+        lowLatency = lowLatency && (si->latencyProfile == LatencyProfile::LOW);
+        if (si->rtt > startLead.worstRtt) {
+            startLead.worstRtt = si->rtt;
+            startLead.worstSink = si->serviceName;
+        }
+
+        /* The workers take turns sending the first packets of each sink's initial fill */
+        si->clockMutex.Lock();
+        uint32_t inputPacketBytes = (si->packetStream != NULL) ? si->packetStream->GetInputPacketBytes() : 0;
+        si->clockMutex.Unlock();
+        if (inputPacketBytes > 0) {
+            uint32_t firstTurn = MIN(si->fifoSize, (uint32_t)MAX_PACKETS_PER_TURN * inputPacketBytes);
+            uint64_t numPackets = MAX((uint64_t)1, ((uint64_t)firstTurn + inputPacketBytes - 1) / inputPacketBytes);
+            si->statsMutex.Lock();
+            uint64_t encodeTime = (si->stats.packetsEmitted > 0) ? si->encodeTimeTotal / si->stats.packetsEmitted : 0;
+            si->statsMutex.Unlock();
+            emitTime += numPackets * (encodeTime + PACKET_EMIT_TIME);
+            numSinks++;
+        }
     }
+    startLead.fillTime = (numSinks > 0) ? emitTime / MIN(numSinks, (size_t)EMIT_WORKERS) : 0;
+    /* One sink with a deep FIFO holds back the group, so keep the normal margin */
+    startLead.margin = lowLatency ? LOW_LATENCY_START_LEAD_MARGIN : START_LEAD_MARGIN;
+    startLead.lead = startLead.worstRtt + startLead.fillTime + startLead.margin;
+
+    /* A source without an end is read as it arrives, so wait for a FIFO's worth before starting */
+    if (mDataSource != NULL && mDataSource->GetInputSize64() == DataSource::UNBOUNDED_INPUT_SIZE) {
+        uint64_t bytesPerSecond = (uint64_t)(mDataSource->GetSampleRate() * mDataSource->GetBytesPerFrame());
+        startLead.bufferTime = (bytesPerSecond > 0) ? (uint64_t)maxFifoSize * 1000000000 / bytesPerSecond : 0;
+    }
+    return startLead;
+}
 
+StartLead SinkPlayer::GetStartLead() {
+    mSinksMutex->Lock();
+    StartLead startLead = ComputeStartLead();
     mSinksMutex->Unlock();
-    return true;
+    return startLead;
 }
 
-bool SinkPlayer::CloseAllSinks() {
-    mSinksMutex->Lock();
-    int count = mSinks.size();
-    if (count == 0) {
-        mSinksMutex->Unlock();
-        return false;
+bool SinkPlayer::CallVolumeProperty(GroupCall* group, const char* name, const char* property, const MsgArg* value) {
+    MsgArg args[3];
+    args[0].Set("s", VOLUME_INTERFACE);
+    args[1].Set("s", property);
+    size_t numArgs = 2;
+    if (value != NULL) {
+        args[2].Set("v", value);
+        numArgs = 3;
     }
 
-    for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-        SinkInfo* si = &(*it);
-        CloseSink(si->serviceName);
+    /* Only sending holds the lock, the replies are waited for without it */
+    const char* method = (value != NULL) ? "Set" : "Get";
+    std::list<SinkInfo*> sinks;
+    mSinksMutex->LockShared();
+    if (name != NULL) {
+        SinkInfo* si = LookupSink(name);
+        if (si != NULL) {
+            sinks.push_back(si);
+        }
+    } else {
+        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+            sinks.push_back(&(*it));
+        }
+    }
+    for (std::list<SinkInfo*>::iterator it = sinks.begin(); it != sinks.end(); ++it) {
+        CallSinkAsync(group, *it, org::freedesktop::DBus::Properties::InterfaceName, method, args, numArgs);
     }
+    mSinksMutex->UnlockShared();
+    return !sinks.empty();
+}
 
-    mSinksMutex->Unlock();
+/**
+ * Gets the property value of a Properties.Get reply, marking the sink
+ * as failed if the reply is malformed.
+ */
+static MsgArg* GetPropertyReply(GroupCall* group, const qcc::String& name, const char* signature) {
+    if (group->results[name] != ER_OK) {
+        return NULL;
+    }
+    MsgArg* value = NULL;
+    std::map<qcc::String, MsgArg>::iterator it = group->values.find(name);
+    if (it == group->values.end() || it->second.Get("v", &value) != ER_OK || strcmp(value->Signature().c_str(), signature) != 0) {
+        QCC_LogError(ER_BUS_BAD_VALUE, ("Bad property reply from %s", name.c_str()));
+        group->results[name] = ER_BUS_BAD_VALUE;
+        return NULL;
+    }
+    return value;
+}
 
-    return true;
+/**
+ * Combines the Mute replies, the group is mute if every sink is.
+ */
+static bool GetMuteReplies(GroupCall* group, bool& mute) {
+    bool success = !group->results.empty();
+    mute = true;
+    for (SinkPlayer::SinkResults::iterator it = group->results.begin(); it != group->results.end(); ++it) {
+        MsgArg* value = GetPropertyReply(group, it->first, "b");
+        if (value == NULL) {
+            success = false;
+            continue;
+        }
+        bool m = false;
+        value->Get("b", &m);
+        mute = mute && m;
+    }
+    return success;
 }
 
-bool SinkPlayer::IsPlaying() {
-    return mState == PlayerState::PLAYING;
+static bool GetVolumeReply(GroupCall* group, int16_t& volume) {
+    bool success = false;
+    for (SinkPlayer::SinkResults::iterator it = group->results.begin(); it != group->results.end(); ++it) {
+        MsgArg* value = GetPropertyReply(group, it->first, "n");
+        if (value != NULL) {
+            value->Get("n", &volume);
+            success = true;
+        }
+    }
+    return success;
 }
 
-bool SinkPlayer::Play() {
-    if (mState != PlayerState::PLAYING) {
-        mSinksMutex->Lock();
-        uint32_t inputDataBytesRemaining = 0;
-        uint64_t timestamp = GetCurrentTimeNanos() + (mSinks.size() * 250000000); /* 0.25s */
-        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-            mEmitThreadsMutex->Lock();
-            SinkInfo* si = &(*it);
-            if (si->mState == SinkInfo::OPENED && mEmitThreads.count(si->serviceName) == 0) {
-                Message playReply(*mMsgBus);
-                QStatus status = si->portObj->MethodCall(AUDIO_SINK_INTERFACE, "Play", NULL, 0, playReply);
-                if (status != ER_OK) {
-                    QCC_LogError(status, ("Play error"));
-                }
+bool SinkPlayer::GetVolumeRange(const char* name, int16_t& low, int16_t& high, int16_t& step, bool refresh) {
+    VolumeState state;
+    if (!refresh && name != NULL && GetCachedVolume(name, state)) {
+        low = state.low;
+        high = state.high;
+        step = state.step;
+        return true;
+    }
 
-                EmitAudioInfo* eai = new EmitAudioInfo;
-                eai->si = si;
-                eai->sp = this;
-                Thread* t = new Thread("EmitAudio", &EmitAudioThread);
-                mEmitThreads[si->serviceName] = t;
-                if (inputDataBytesRemaining == 0) {
-                    // Save value from first sink
-                    inputDataBytesRemaining = si->inputDataBytesRemaining;
-                } else {
-                    // Apply to all other sinks
-                    si->inputDataBytesRemaining = inputDataBytesRemaining;
-                }
-                si->timestamp = timestamp;
-                t->Start(eai);
-            }
-            mEmitThreadsMutex->Unlock();
-        }
-        mSinksMutex->Unlock();
+    GroupCall group;
+    if (name == NULL || !CallVolumeProperty(&group, name, "VolumeRange", NULL)) {
+        return false;
+    }
+    uint64_t begin = GetCurrentTimeNanos();
+    bool success = group.Wait(NULL);
+    UpdateRtts(&group);
+
+    MsgArg* value = success ? GetPropertyReply(&group, name, "(nnn)") : NULL;
+    if (value == NULL) {
+        QCC_LogError(ER_FAIL, ("Get volume range error"));
+        return false;
+    }
+    value->Get("(nnn)", &low, &high, &step);
+    CacheVolumeResults(&group, "VolumeRange", NULL);
+    QCC_DbgHLPrintf(("Get volume range took %" PRIu64 " ns", GetCurrentTimeNanos() - begin));
+    return true;
+}
 
-        mState = PlayerState::PLAYING;
+bool SinkPlayer::GetVolume(const char* name, int16_t& volume, bool refresh) {
+    VolumeState state;
+    if (!refresh && name != NULL && GetCachedVolume(name, state)) {
+        volume = state.volume;
+        return true;
+    }
 
-        uint64_t now = GetCurrentTimeNanos();
-        if (now > timestamp) {
-            QCC_DbgHLPrintf(("Play calls finished after timestamp by %" PRIu64 " nanos", now - timestamp));
-        }
+    GroupCall group;
+    if (name == NULL || !CallVolumeProperty(&group, name, "Volume", NULL)) {
+        return false;
     }
+    uint64_t begin = GetCurrentTimeNanos();
+    group.Wait(NULL);
+    UpdateRtts(&group);
 
+    if (!GetVolumeReply(&group, volume)) {
+        QCC_LogError(ER_FAIL, ("Get volume error"));
+        return false;
+    }
+    CacheVolumeResults(&group, "Volume", NULL);
+    QCC_DbgHLPrintf(("Get volume took %" PRIu64 " ns", GetCurrentTimeNanos() - begin));
     return true;
 }
 
-bool SinkPlayer::Pause() {
-    if (mState == PlayerState::PLAYING) {
-        mSinksMutex->Lock();
-        uint64_t pauseTimeNanos = GetCurrentTimeNanos() + (mSinks.size() * 250000000); /* 0.25s */
-        uint64_t flushTimeNanos = pauseTimeNanos + 1000000;
-        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-            mEmitThreadsMutex->Lock();
-            SinkInfo* si = &(*it);
-            if (si->mState == SinkInfo::OPENED && mEmitThreads.count(si->serviceName) > 0) {
-                Message pauseReply(*mMsgBus);
-                MsgArg pauseArgs("t", pauseTimeNanos);
-                QStatus status = si->portObj->MethodCall(AUDIO_SINK_INTERFACE, "Pause", &pauseArgs, 1, pauseReply);
-                if (status != ER_OK) {
-                    QCC_LogError(status, ("Pause error"));
-                }
+bool SinkPlayer::SetVolume(const char* name, int16_t volume) {
+    GroupCall group;
+    MsgArg value("n", volume);
+    if (name == NULL || !CallVolumeProperty(&group, name, "Volume", &value)) {
+        return false;
+    }
+    uint64_t begin = GetCurrentTimeNanos();
+    bool success = group.Wait(NULL);
+    UpdateRtts(&group);
 
-                mEmitThreadsMutex->Lock();
-                Thread* t = mEmitThreads[si->serviceName];
-                mEmitThreadsMutex->Unlock();
-                t->Stop();
-                t->Join();
-                mEmitThreadsMutex->Lock();
-                mEmitThreads.erase(si->serviceName);
-                mEmitThreadsMutex->Unlock();
-
-                Message flushReply(*mMsgBus);
-                MsgArg flushArgs("t", flushTimeNanos);
-                status = si->portObj->MethodCallAsync(AUDIO_SINK_INTERFACE, "Flush",
-                                                      this, static_cast<MessageReceiver::ReplyHandler>(&SinkPlayer::FlushReplyHandler),
-                                                      &flushArgs, 1, si);
-                if (status != ER_OK) {
-                    QCC_LogError(status, ("Flush error"));
-                }
-            }
-            mEmitThreadsMutex->Unlock();
-        }
-        mSinksMutex->Unlock();
+    CacheVolumeResults(&group, "Volume", &value);
+    if (success) {
+        QCC_DbgHLPrintf(("Set volume took %" PRIu64 " ns", GetCurrentTimeNanos() - begin));
+    } else {
+        QCC_LogError(ER_FAIL, ("Set volume error"));
+    }
+    return success;
+}
 
-        mState = PlayerState::PAUSED;
+bool SinkPlayer::GetMute(const char* name, bool& mute, bool refresh) {
+    VolumeState state;
+    if (!refresh && GetCachedVolume(name, state)) {
+        mute = state.mute;
+        return true;
+    }
 
-        uint64_t now = GetCurrentTimeNanos();
-        if (now > pauseTimeNanos) {
-            QCC_DbgHLPrintf(("Pause calls finished after timestamp by %" PRIu64 " nanos", now - pauseTimeNanos));
-        }
+    GroupCall group;
+    if (!CallVolumeProperty(&group, name, "Mute", NULL)) {
+        return false;
     }
+    uint64_t begin = GetCurrentTimeNanos();
+    group.Wait(NULL);
+    UpdateRtts(&group);
 
+    /* Every sink is asked at once, so the group takes one round trip */
+    if (!GetMuteReplies(&group, mute)) {
+        QCC_LogError(ER_FAIL, ("Get mute error"));
+        return false;
+    }
+    CacheVolumeResults(&group, "Mute", NULL);
+    QCC_DbgHLPrintf(("Get mute took %" PRIu64 " ns", GetCurrentTimeNanos() - begin));
     return true;
 }
 
-bool SinkPlayer::GetVolumeRange(const char* name, int16_t& low, int16_t& high, int16_t& step) {
-    uint64_t begin, end;
-    bool success = false;
-    mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-    if (it != mSinks.end()) {
-        SinkInfo* si = &(*it);
-        MsgArg reply;
-        begin = GetCurrentTimeNanos();
-        QStatus status = si->portObj->GetProperty(VOLUME_INTERFACE, "VolumeRange", reply);
-        end = GetCurrentTimeNanos();
-        if (status == ER_OK) {
-            status = reply.Get("(nnn)", &low, &high, &step);
-        }
-        if (status == ER_OK) {
-            success = true;
-            QCC_DbgHLPrintf(("Get volume range took %" PRIu64 " ns", end - begin));
-        } else {
-            success = false;
-            QCC_LogError(status, ("Get volume range error"));
-        }
+bool SinkPlayer::SetMute(const char* name, bool mute) {
+    GroupCall group;
+    MsgArg value("b", mute);
+    if (!CallVolumeProperty(&group, name, "Mute", &value)) {
+        return false;
     }
-    mSinksMutex->Unlock();
+    uint64_t begin = GetCurrentTimeNanos();
+    bool success = group.Wait(NULL);
+    UpdateRtts(&group);
 
+    CacheVolumeResults(&group, "Mute", &value);
+    if (success) {
+        QCC_DbgHLPrintf(("Set mute took %" PRIu64 " ns", GetCurrentTimeNanos() - begin));
+    } else {
+        QCC_LogError(ER_FAIL, ("Set mute error"));
+    }
     return success;
 }
 
-bool SinkPlayer::GetVolume(const char* name, int16_t& volume) {
-    uint64_t begin, end;
-    bool success = false;
-    mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-    if (it != mSinks.end()) {
-        SinkInfo* si = &(*it);
-        MsgArg reply;
-        begin = GetCurrentTimeNanos();
-        QStatus status = si->portObj->GetProperty(VOLUME_INTERFACE, "Volume", reply);
-        end = GetCurrentTimeNanos();
-        if (status == ER_OK) {
-            status = reply.Get("n", &volume);
+void SinkPlayer::SeedVolumeCache(SinkInfo* si) {
+    /* One round trip for all the properties, after that the signals keep the cache current */
+    MsgArg props;
+    QStatus status = si->portObj->GetAllProperties(VOLUME_INTERFACE, props);
+    if (status != ER_OK) {
+        QCC_DbgHLPrintf(("Not caching the volume of %s: %s", si->serviceName, QCC_StatusText(status)));
+        return;
+    }
+
+    size_t numProps = 0;
+    MsgArg* entries = NULL;
+    status = props.Get("a{sv}", &numProps, &entries);
+    VolumeState state;
+    size_t found = 0;
+    for (size_t i = 0; status == ER_OK && i < numProps; i++) {
+        char* key = NULL;
+        MsgArg* value = NULL;
+        if (entries[i].Get("{sv}", &key, &value) != ER_OK) {
+            continue;
         }
-        if (status == ER_OK) {
-            success = true;
-            QCC_DbgHLPrintf(("Get volume took %" PRIu64 " ns", end - begin));
-        } else {
-            success = false;
-            QCC_LogError(status, ("Get volume error"));
+        if (strcmp(key, "Mute") == 0 && value->Get("b", &state.mute) == ER_OK) {
+            found++;
+        } else if (strcmp(key, "Volume") == 0 && value->Get("n", &state.volume) == ER_OK) {
+            found++;
+        } else if (strcmp(key, "VolumeRange") == 0 && value->Get("(nnn)", &state.low, &state.high, &state.step) == ER_OK) {
+            found++;
         }
     }
-    mSinksMutex->Unlock();
+    if (found != 3) {
+        QCC_LogError(ER_BUS_BAD_VALUE, ("Not caching the volume of %s: incomplete properties", si->serviceName));
+        return;
+    }
 
-    return success;
+    state.objectPath = si->portObj->GetPath();
+    mVolumeCacheMutex->Lock();
+    mVolumeCache[si->sessionId] = state;
+    mVolumeCacheMutex->Unlock();
 }
 
-bool SinkPlayer::SetVolume(const char* name, int16_t volume) {
-    uint64_t begin, end;
-    bool success = false;
-    mSinksMutex->Lock();
-    std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-    if (it != mSinks.end()) {
-        SinkInfo* si = &(*it);
-        MsgArg arg("n", volume);
-        begin = GetCurrentTimeNanos();
-        QStatus status = si->portObj->SetProperty(VOLUME_INTERFACE, "Volume", arg);
-        end = GetCurrentTimeNanos();
-        if (status == ER_OK) {
-            success = true;
-            QCC_DbgHLPrintf(("Set volume took %" PRIu64 " ns", end - begin));
+bool SinkPlayer::GetCachedVolume(const char* name, VolumeState& state) {
+    /* A group is served from the cache only if every sink is cached, the mute state is then combined */
+    std::list<SessionId> sessionIds;
+    mSinksMutex->LockShared();
+    if (name != NULL) {
+        SinkInfo* si = LookupSink(name);
+        if (si != NULL) {
+            sessionIds.push_back(si->sessionId);
+        }
+    } else {
+        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
+            sessionIds.push_back(it->sessionId);
+        }
+    }
+    mSinksMutex->UnlockShared();
+
+    bool cached = false;
+    mVolumeCacheMutex->Lock();
+    for (std::list<SessionId>::iterator it = sessionIds.begin(); it != sessionIds.end(); ++it) {
+        VolumeCache::iterator cit = mVolumeCache.find(*it);
+        if (cit == mVolumeCache.end()) {
+            cached = false;
+            break;
+        }
+        if (!cached) {
+            state = cit->second;
+            cached = true;
         } else {
-            success = false;
-            QCC_LogError(status, ("Set volume error"));
+            state.mute = state.mute && cit->second.mute;
         }
     }
-    mSinksMutex->Unlock();
-
-    return success;
+    mVolumeCacheMutex->Unlock();
+    return cached;
 }
 
-bool SinkPlayer::GetMute(const char* name, bool& mute) {
-    uint64_t begin, end;
-    bool success = false;
-    mSinksMutex->Lock();
-    if (name) {
-        std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-        if (it != mSinks.end()) {
-            SinkInfo* si = &(*it);
-            MsgArg reply;
-            begin = GetCurrentTimeNanos();
-            QStatus status = si->portObj->GetProperty(VOLUME_INTERFACE, "Mute", reply);
-            end = GetCurrentTimeNanos();
-            if (status == ER_OK) {
-                status = reply.Get("b", &mute);
-            }
-            if (status == ER_OK) {
-                success = true;
-                QCC_DbgHLPrintf(("Get mute took %" PRIu64 " ns", end - begin));
-            } else {
-                success = false;
-                QCC_LogError(status, ("Get mute error"));
-            }
+void SinkPlayer::CacheVolumeResults(GroupCall* group, const char* property, const MsgArg* value) {
+    mSinksMutex->LockShared();
+    for (SinkResults::iterator it = group->results.begin(); it != group->results.end(); ++it) {
+        if (it->second != ER_OK) {
+            continue;
         }
-    } else if (!mSinks.empty()) {
-        success = true;
-        mute = true;
-        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-            SinkInfo* si = &(*it);
-            bool m;
-            MsgArg reply;
-            begin = GetCurrentTimeNanos();
-            QStatus status = si->portObj->GetProperty(VOLUME_INTERFACE, "Mute", reply);
-            end = GetCurrentTimeNanos();
-            if (status == ER_OK) {
-                status = reply.Get("b", &m);
-            }
-            if (status == ER_OK) {
-                mute = mute && m;
-                QCC_DbgHLPrintf(("Get mute took %" PRIu64 " ns", end - begin));
-            } else {
-                success = false;
-                QCC_LogError(status, ("Get mute error"));
-            }
+        SinkInfo* si = LookupSink(it->first.c_str());
+        if (si == NULL) {
+            continue;
         }
+
+        /* A Set stored value, a Get returned it wrapped in a variant */
+        const MsgArg* v = value;
+        std::map<qcc::String, MsgArg>::iterator vit = group->values.find(it->first);
+        if (v == NULL && (vit == group->values.end() || vit->second.Get("v", &v) != ER_OK)) {
+            continue;
+        }
+        CacheVolumeValue(si->sessionId, property, *v);
     }
-    mSinksMutex->Unlock();
+    mSinksMutex->UnlockShared();
+}
 
-    return success;
+void SinkPlayer::CacheVolumeValue(SessionId sessionId, const char* property, const MsgArg& value, const char* objectPath) {
+    mVolumeCacheMutex->Lock();
+    VolumeCache::iterator it = mVolumeCache.find(sessionId);
+    /* A signal only updates the state if it comes from the sink's own object */
+    if (it != mVolumeCache.end() && (objectPath == NULL || it->second.objectPath == objectPath)) {
+        VolumeState& state = it->second;
+        if (strcmp(property, "Mute") == 0) {
+            value.Get("b", &state.mute);
+        } else if (strcmp(property, "Volume") == 0) {
+            value.Get("n", &state.volume);
+        } else if (strcmp(property, "VolumeRange") == 0) {
+            value.Get("(nnn)", &state.low, &state.high, &state.step);
+        }
+    }
+    mVolumeCacheMutex->Unlock();
 }
 
-bool SinkPlayer::SetMute(const char* name, bool mute) {
-    uint64_t begin, end;
-    bool success = false;
-    mSinksMutex->Lock();
-    if (name) {
-        std::list<SinkInfo>::iterator it = find_if(mSinks.begin(), mSinks.end(), FindSink(name));
-        if (it != mSinks.end()) {
-            SinkInfo* si = &(*it);
-            MsgArg arg("b", mute);
-            begin = GetCurrentTimeNanos();
-            QStatus status = si->portObj->SetProperty(VOLUME_INTERFACE, "Mute", arg);
-            end = GetCurrentTimeNanos();
-            if (status == ER_OK) {
-                success = true;
-                QCC_DbgHLPrintf(("Set mute took %" PRIu64 " ns", end - begin));
-            } else {
-                success = false;
-                QCC_LogError(status, ("Set mute error"));
+struct VolumeCallInfo {
+    char* name;
+    const char* property;
+    bool set;
+    MsgArg value;
+    SinkPlayer::VolumeCallback* callback;
+    void* context;
+    SinkPlayer* sp;
+    VolumeCallInfo() : name(NULL), property(NULL), set(false), callback(NULL), context(NULL), sp(NULL) { }
+};
+
+bool SinkPlayer::GetMuteAsync(const char* name, VolumeCallback* callback, void* context) {
+    return QueueVolumeCall(name, "Mute", NULL, callback, context);
+}
+
+bool SinkPlayer::SetMuteAsync(const char* name, bool mute, VolumeCallback* callback, void* context) {
+    MsgArg value("b", mute);
+    return QueueVolumeCall(name, "Mute", &value, callback, context);
+}
+
+bool SinkPlayer::GetVolumeAsync(const char* name, VolumeCallback* callback, void* context) {
+    if (name == NULL) {
+        return false;
+    }
+    return QueueVolumeCall(name, "Volume", NULL, callback, context);
+}
+
+bool SinkPlayer::SetVolumeAsync(const char* name, int16_t volume, VolumeCallback* callback, void* context) {
+    if (name == NULL) {
+        return false;
+    }
+    MsgArg value("n", volume);
+    return QueueVolumeCall(name, "Volume", &value, callback, context);
+}
+
+bool SinkPlayer::QueueVolumeCall(const char* name, const char* property, const MsgArg* value, VolumeCallback* callback, void* context) {
+    if ((name != NULL) ? !HasSink(name) : (GetSinkCount() == 0)) {
+        return false;
+    }
+
+    VolumeCallInfo* vci = new VolumeCallInfo;
+    vci->name = (name != NULL) ? strdup(name) : NULL;
+    vci->property = property;
+    vci->set = (value != NULL);
+    if (value != NULL) {
+        vci->value = *value;
+    }
+    vci->callback = callback;
+    vci->context = context;
+    vci->sp = this;
+
+    mVolumeCacheMutex->Lock();
+    mPendingVolumeCalls++;
+    mVolumeCacheMutex->Unlock();
+
+    /* No worker waits for the replies, the last one to arrive finishes the call */
+    GroupCall* group = new GroupCall;
+    group->volumeCall = vci;
+    group->Hold();
+    CallVolumeProperty(group, vci->name, vci->property, vci->set ? &vci->value : NULL);
+    if (group->Release()) {
+        FinishVolumeCall(group);
+    }
+    return true;
+}
+
+void SinkPlayer::FinishVolumeCall(GroupCall* group) {
+    /* Reply handlers must not wait for mSinksMutex, so the results are handled by a job */
+    if (mControlPool->Execute(&VolumeCallDoneJob, group, this) != ER_OK) {
+        DeleteVolumeCall(group);
+    }
+}
+
+void SinkPlayer::DeleteVolumeCall(GroupCall* group) {
+    VolumeCallInfo* vci = group->volumeCall;
+    if (vci->name != NULL) {
+        free((void*)vci->name);
+    }
+    delete vci;
+    delete group;
+
+    mVolumeCacheMutex->Lock();
+    if (--mPendingVolumeCalls == 0) {
+        mVolumeCallsDoneEvent->SetEvent();
+    }
+    mVolumeCacheMutex->Unlock();
+}
+
+ThreadReturn SinkPlayer::VolumeCallDoneJob(void* arg) {
+    GroupCall* group = reinterpret_cast<GroupCall*>(arg);
+    VolumeCallInfo* vci = group->volumeCall;
+    SinkPlayer* sp = vci->sp;
+
+    sp->UpdateRtts(group);
+    sp->CacheVolumeResults(group, vci->property, vci->set ? &vci->value : NULL);
+
+    if (strcmp(vci->property, "Mute") == 0) {
+        if (vci->set) {
+            if (vci->callback != NULL) {
+                vci->callback->SetMuteDone(vci->name, group->results, vci->context);
+            }
+        } else {
+            bool mute = false;
+            GetMuteReplies(group, mute);
+            if (vci->callback != NULL) {
+                vci->callback->GetMuteDone(vci->name, mute, group->results, vci->context);
             }
-            success = (status == ER_OK);
         }
-    } else if (!mSinks.empty()) {
-        success = true;
-        for (std::list<SinkInfo>::iterator it = mSinks.begin(); it != mSinks.end(); ++it) {
-            SinkInfo* si = &(*it);
-            MsgArg arg("b", mute);
-            begin = GetCurrentTimeNanos();
-            QStatus status = si->portObj->SetProperty(VOLUME_INTERFACE, "Mute", arg);
-            end = GetCurrentTimeNanos();
-            if (status == ER_OK) {
-                QCC_DbgHLPrintf(("Set mute took %" PRIu64 " ns", end - begin));
-            } else {
-                success = false;
-                QCC_LogError(status, ("Set mute error"));
+    } else {
+        if (vci->set) {
+            if (vci->callback != NULL) {
+                vci->callback->SetVolumeDone(vci->name, group->results, vci->context);
+            }
+        } else {
+            int16_t volume = 0;
+            GetVolumeReply(group, volume);
+            if (vci->callback != NULL) {
+                vci->callback->GetVolumeDone(vci->name, volume, group->results, vci->context);
             }
         }
     }
-    mSinksMutex->Unlock();
 
-    return success;
+    sp->DeleteVolumeCall(group);
+    return NULL;
 }
 
 void SinkPlayer::FlushReplyHandler(Message& msg, void* context) {
+    FlushCall* flush = reinterpret_cast<FlushCall*>(context);
+
     size_t numArgs = 0;
     const MsgArg* args = NULL;
     msg->GetArgs(numArgs, args);
 
     if (numArgs != 1) {
         QCC_LogError(ER_BAD_ARG_COUNT, ("Flush reply has invalid number of arguments"));
+        delete flush;
         return;
     }
 
+    /* The sink is looked up under the sinks lock, which is not taken on the dispatcher */
+    flush->flushedBytes = args[0].v_uint32;
+    if (mControlPool->Execute(&FlushDoneJob, flush, this) != ER_OK) {
+        delete flush;
+    }
+}
+
+ThreadReturn SinkPlayer::FlushDoneJob(void* arg) {
+    FlushCall* flush = reinterpret_cast<FlushCall*>(arg);
+    flush->sp->FlushDone(flush);
+    delete flush;
+    return NULL;
+}
+
+void SinkPlayer::FlushDone(FlushCall* flush) {
     if (mState != PlayerState::PAUSED) {
         QCC_DbgHLPrintf(("Ignoring flush reply as state is not paused"));
         return;
     }
 
-    SinkInfo* si = reinterpret_cast<SinkInfo*>(context);
+    mSinksMutex->LockShared();
+    SinkInfo* si = LookupSink(flush->name.c_str());
+    if (si != NULL && si->mState == SinkInfo::OPENED) {
+        uint32_t inputPacketBytes = mDataSource->GetBytesPerFrame() * si->framesPerPacket;
+        uint32_t flushedBytes = flush->flushedBytes - (flush->flushedBytes % inputPacketBytes);
+        si->clockMutex.Lock();
+        if (si->flushGeneration != flush->generation) {
+            QCC_DbgHLPrintf(("Ignoring flush reply from %s as it was seeked since", si->serviceName));
+        } else if (flushedBytes < si->inputOffset) {
+            /* Adjust value so that when playback is resumed we resend flushed data, mostly from the packet history */
+            si->inputOffset -= flushedBytes;
+        } else {
+            si->inputOffset = 0;
+        }
+        si->clockMutex.Unlock();
+    }
+    mSinksMutex->UnlockShared();
+}
 
-    uint32_t inputPacketBytes = mDataSource->GetBytesPerFrame() * si->framesPerPacket;
-    uint32_t flushedBytes = msg->GetArg(0)->v_uint32;
-    flushedBytes = flushedBytes - (flushedBytes % inputPacketBytes);
-    if (si->inputDataBytesRemaining + flushedBytes < mDataSource->GetInputSize()) {
-        /* Adjust value so that when playback is resumed we resend flushed data */
-        si->inputDataBytesRemaining += flushedBytes;
+PacketStream* SinkPlayer::AcquirePacketStream(const char* type, uint32_t framesPerPacket) {
+    mPacketStreamsMutex->Lock();
+    PacketStream* ps = NULL;
+    PacketStreamKey key(type, framesPerPacket);
+    PacketStreamMap::iterator it = mPacketStreams.find(key);
+    if (it != mPacketStreams.end()) {
+        ps = it->second;
     } else {
-        si->inputDataBytesRemaining = mDataSource->GetInputSize();
+        ps = new PacketStream(type, mTrackQueue, framesPerPacket);
+        ps->SetReadAhead(mReadAheadDuration);
+        mPacketStreams[key] = ps;
+        mReadAheadWorker->mutex.Lock();
+        mReadAheadWorker->streams.insert(ps);
+        mReadAheadWorker->mutex.Unlock();
+    }
+    ps->AddRef();
+    mPacketStreamsMutex->Unlock();
+    return ps;
+}
+
+void SinkPlayer::ReleasePacketStream(PacketStream* ps) {
+    mPacketStreamsMutex->Lock();
+    if (ps->DecRef() == 0) {
+        mPacketStreams.erase(PacketStreamKey(ps->GetType(), ps->GetFrameSize()));
+        mReadAheadWorker->mutex.Lock();
+        mReadAheadWorker->streams.erase(ps);
+        mReadAheadWorker->mutex.Unlock();
+        delete ps;
     }
+    mPacketStreamsMutex->Unlock();
 }
 
 void SinkPlayer::FreeSinkInfo(SinkInfo* si) {
@@ -1321,25 +4164,17 @@ void SinkPlayer::FreeSinkInfo(SinkInfo* si) {
         si->serviceName = NULL;
     }
 
+    if (si->cacheKey != NULL) {
+        free((void*)si->cacheKey);
+        si->cacheKey = NULL;
+    }
+
     if (si->streamObj != NULL) {
         delete si->streamObj;
         si->streamObj = NULL;
     }
 
-    if (si->encoder != NULL) {
-        delete si->encoder;
-        si->encoder = NULL;
-    }
-
-    if (si->capabilities != NULL) {
-        delete [] si->capabilities;
-        si->capabilities = NULL;
-    }
-
-    if (si->selectedCapability != NULL) {
-        delete si->selectedCapability;
-        si->selectedCapability = NULL;
-    }
+    ResetSinkFormat(si);
 
     if (si->fifoPositionHandler != NULL) {
         delete si->fifoPositionHandler;
@@ -1349,6 +4184,10 @@ void SinkPlayer::FreeSinkInfo(SinkInfo* si) {
 
 void SinkPlayer::MuteChangedSignalHandler(const InterfaceDescription::Member* member,
                                           const char* sourcePath, Message& msg) {
+    if (msg->GetArg(0) != NULL) {
+        CacheVolumeValue(msg->GetSessionId(), "Mute", *msg->GetArg(0), msg->GetObjectPath());
+    }
+
     mSinkListenersMutex->Lock();
     if (mSinkListenerThread) {
         mSinkListenerQueue.push_back(msg);
@@ -1359,6 +4198,10 @@ void SinkPlayer::MuteChangedSignalHandler(const InterfaceDescription::Member* me
 
 void SinkPlayer::VolumeChangedSignalHandler(const InterfaceDescription::Member* member,
                                             const char* sourcePath, Message& msg) {
+    if (msg->GetArg(0) != NULL) {
+        CacheVolumeValue(msg->GetSessionId(), "Volume", *msg->GetArg(0), msg->GetObjectPath());
+    }
+
     mSinkListenersMutex->Lock();
     if (mSinkListenerThread) {
         mSinkListenerQueue.push_back(msg);
@@ -1382,22 +4225,18 @@ ThreadReturn SinkPlayer::SinkListenerThread(void* arg) {
                 sp->mSinkListenerQueue.pop_front();
                 sp->mSinkListenersMutex->Unlock();
 
-                SinkInfo si;
-                sp->mSinksMutex->Lock();
-                std::list<SinkInfo>::iterator sit;
-                for (sit = sp->mSinks.begin(); sit != sp->mSinks.end(); ++sit) {
-                    si = (*sit);
-                    if (si.portObj->GetPath() == msg->GetObjectPath() && si.sessionId == msg->GetSessionId()) {
-                        break;
-                    }
+                qcc::String name;
+                sp->mSinksMutex->LockShared();
+                SinkInfo* si = sp->LookupSink(msg->GetSessionId());
+                if (si != NULL && si->portObj != NULL && si->portObj->GetPath() == msg->GetObjectPath()) {
+                    name = si->serviceName;
                 }
-                if (sit == sp->mSinks.end()) {
+                sp->mSinksMutex->UnlockShared();
+                if (name.empty()) {
                     // Ignore signal from unknown sink
-                    sp->mSinksMutex->Unlock();
                     sp->mSinkListenersMutex->Lock();
                     continue;
                 }
-                sp->mSinksMutex->Unlock();
 
                 if (strcmp("MuteChanged", msg->GetMemberName()) == 0) {
                     bool mute;
@@ -1412,7 +4251,7 @@ ThreadReturn SinkPlayer::SinkListenerThread(void* arg) {
                     SinkListeners::iterator it = sp->mSinkListeners.begin();
                     while (it != sp->mSinkListeners.end()) {
                         SinkListener* listener = *it;
-                        listener->MuteChanged(si.serviceName, mute);
+                        listener->MuteChanged(name.c_str(), mute);
                         it = sp->mSinkListeners.upper_bound(listener);
                     }
                     sp->mSinkListenersMutex->Unlock();
@@ -1430,7 +4269,7 @@ ThreadReturn SinkPlayer::SinkListenerThread(void* arg) {
                     SinkListeners::iterator it = sp->mSinkListeners.begin();
                     while (it != sp->mSinkListeners.end()) {
                         SinkListener* listener = *it;
-                        listener->VolumeChanged(si.serviceName, volume);
+                        listener->VolumeChanged(name.c_str(), volume);
                         it = sp->mSinkListeners.upper_bound(listener);
                     }
                     sp->mSinkListenersMutex->Unlock();
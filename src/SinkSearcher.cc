@@ -19,6 +19,7 @@
 
 #include "Sink.h"
 #include <qcc/Debug.h>
+#include <qcc/StringUtil.h>
 
 #define QCC_MODULE "ALLJOYN_AUDIO"
 
@@ -93,6 +94,21 @@ void SinkSearcher::OnAnnounce(const InterfaceDescription::Member* member, const
     } else {
         service.friendlyName = deviceName;
     }
+    const char* deviceId = NULL;
+    status = message->GetArg(3)->GetElement("{ss}", ANNOUNCE_DEVICE_ID, &deviceId);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to get DeviceId"));
+    } else {
+        service.deviceId = deviceId;
+    }
+    size_t appIdLen = 0;
+    uint8_t* appId = NULL;
+    status = message->GetArg(3)->GetElement("{say}", ANNOUNCE_APP_ID, &appIdLen, &appId);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to get AppId"));
+    } else {
+        service.appId = BytesToHexString(appId, appIdLen);
+    }
 
     /*
      * Now we've got all the info we need to join a session and begin doing useful work so cache it.
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <alljoyn/audio/StreamingDataSource.h>
+
+#include <qcc/Debug.h>
+#include <qcc/Mutex.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QCC_MODULE "ALLJOYN_AUDIO"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define MIN_STREAM_HISTORY_SIZE (64 * 1024) /* Bytes, enough for the largest packet */
+
+namespace ajn {
+namespace services {
+
+StreamingDataSource::StreamingDataSource(uint32_t historyMs) : DataSource(),
+    mHistoryDuration(historyMs), mReadMutex(new qcc::Mutex()), mMutex(new qcc::Mutex()), mBuffer(NULL), mBufferSize(0), mStart(0), mEnd(0),
+    mEndOfStream(false) {
+}
+
+StreamingDataSource::~StreamingDataSource() {
+    free(mBuffer);
+    delete mMutex;
+    delete mReadMutex;
+}
+
+uint32_t StreamingDataSource::GetInputSize() {
+    return (uint32_t)MIN(GetInputSize64(), (uint64_t)0xFFFFFFFF);
+}
+
+uint64_t StreamingDataSource::GetInputSize64() {
+    return UNBOUNDED_INPUT_SIZE;
+}
+
+size_t StreamingDataSource::ReadData(uint8_t* buffer, size_t offset, size_t length) {
+    return ReadData64(buffer, offset, length);
+}
+
+size_t StreamingDataSource::ReadData64(uint8_t* buffer, uint64_t offset, size_t length) {
+    mMutex->Lock();
+    if (mBuffer == NULL) {
+        /* The format getters are only usable once the subclass is constructed */
+        uint64_t frames = (uint64_t)mHistoryDuration * GetSampleRate() / 1000;
+        mBufferSize = MAX((size_t)(frames * GetBytesPerFrame()), (size_t)MIN_STREAM_HISTORY_SIZE);
+        mBuffer = (uint8_t*)malloc(mBufferSize);
+    }
+
+    /* Read the stream on, dropping the oldest data to make room */
+    length = MIN(length, mBufferSize);
+    while (offset >= mStart && offset + length > mEnd && !mEndOfStream) {
+        /* Only one reader reads the stream, the others copy from the history meanwhile */
+        mMutex->Unlock();
+        mReadMutex->Lock();
+        mMutex->Lock();
+        if (offset >= mStart && offset + length > mEnd && !mEndOfStream) {
+            uint64_t end = mEnd;
+            size_t pos = (size_t)(end % mBufferSize);
+            size_t chunk = (size_t)MIN((uint64_t)(mBufferSize - pos), offset + length - end);
+            if (end + chunk > mStart + mBufferSize) {
+                /* Dropped before the read, so that no copy is made of the data being overwritten */
+                mStart = end + chunk - mBufferSize;
+            }
+            mMutex->Unlock();
+            size_t numBytes = ReadStream(mBuffer + pos, chunk);
+            mMutex->Lock();
+            mEnd = end + numBytes;
+            mEndOfStream = (numBytes == 0);
+        }
+        mReadMutex->Unlock();
+    }
+
+    if (offset < mStart) {
+        mMutex->Unlock();
+        QCC_LogError(ER_FAIL, ("Offset %" PRIu64 " is no longer kept, the stream is at %" PRIu64, offset, mEnd));
+        return 0;
+    }
+
+    size_t numBytes = 0;
+    if (offset < mEnd) {
+        numBytes = (size_t)MIN((uint64_t)length, mEnd - offset);
+        size_t pos = (size_t)(offset % mBufferSize);
+        size_t first = MIN(numBytes, mBufferSize - pos);
+        memcpy(buffer, mBuffer + pos, first);
+        memcpy(buffer + first, mBuffer, numBytes - first);
+    }
+    mMutex->Unlock();
+    return numBytes;
+}
+
+}
+}
@@ -0,0 +1,262 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "TrackQueue.h"
+
+#include <qcc/Debug.h>
+#include <inttypes.h>
+
+#define QCC_MODULE "ALLJOYN_AUDIO"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+using namespace qcc;
+
+namespace ajn {
+namespace services {
+
+TrackQueue::TrackQueue(DataSource* dataSource) : mNextOffset(0) {
+    mSampleRate = dataSource->GetSampleRate();
+    mBytesPerFrame = dataSource->GetBytesPerFrame();
+    mChannelsPerFrame = dataSource->GetChannelsPerFrame();
+    mBitsPerChannel = dataSource->GetBitsPerChannel();
+
+    Track track;
+    track.dataSource = dataSource;
+    track.start = 0;
+    track.size = dataSource->GetInputSize64();
+    track.numViews = 0;
+    mTracks.push_back(track);
+}
+
+bool TrackQueue::IsCompatible(DataSource* dataSource) {
+    return dataSource->GetSampleRate() == mSampleRate &&
+           dataSource->GetBytesPerFrame() == mBytesPerFrame &&
+           dataSource->GetChannelsPerFrame() == mChannelsPerFrame &&
+           dataSource->GetBitsPerChannel() == mBitsPerChannel;
+}
+
+bool TrackQueue::Append(DataSource* dataSource, uint64_t& start) {
+    if (!IsCompatible(dataSource)) {
+        return false;
+    }
+
+    mMutex.Lock();
+    if (mTracks.back().size == UNBOUNDED_INPUT_SIZE) {
+        mMutex.Unlock();
+        return false;
+    }
+    Track track;
+    track.dataSource = dataSource;
+    track.start = mTracks.back().start + mTracks.back().size;
+    track.size = dataSource->GetInputSize64();
+    if (track.size != UNBOUNDED_INPUT_SIZE && track.size > UNBOUNDED_INPUT_SIZE - track.start) {
+        track.size = UNBOUNDED_INPUT_SIZE - track.start;
+    }
+    track.numViews = 0;
+    mTracks.push_back(track);
+    start = track.start;
+    mMutex.Unlock();
+
+    QCC_DbgHLPrintf(("Queued track at offset %" PRIu64, start));
+    return true;
+}
+
+void TrackQueue::Release(uint64_t offset, std::vector<DataSource*>& dataSources) {
+    mMutex.Lock();
+    size_t count = 0;
+    /* Only the last track can be without an end, so the others never overflow */
+    while (count + 1 < mTracks.size() && mTracks[count].start + mTracks[count].size <= offset) {
+        if (mTracks[count].numViews > 0) {
+            /* Packets still point into the track, it goes once they are freed */
+            break;
+        }
+        dataSources.push_back(mTracks[count].dataSource);
+        count++;
+    }
+    if (count > 0) {
+        mTracks.erase(mTracks.begin(), mTracks.begin() + count);
+        QCC_DbgHLPrintf(("Released %zu tracks, queue starts at offset %" PRIu64, count, mTracks[0].start));
+    }
+    mMutex.Unlock();
+}
+
+void TrackQueue::GetDataSources(std::vector<DataSource*>& dataSources) {
+    mMutex.Lock();
+    for (size_t i = 0; i < mTracks.size(); i++) {
+        dataSources.push_back(mTracks[i].dataSource);
+    }
+    mMutex.Unlock();
+}
+
+size_t TrackQueue::GetTrackCount() {
+    mMutex.Lock();
+    size_t count = mTracks.size();
+    mMutex.Unlock();
+    return count;
+}
+
+uint64_t TrackQueue::GetStart() {
+    mMutex.Lock();
+    uint64_t start = mTracks[0].start;
+    mMutex.Unlock();
+    return start;
+}
+
+uint32_t TrackQueue::GetInputSize() {
+    return (uint32_t)MIN(GetInputSize64(), (uint64_t)0xFFFFFFFF);
+}
+
+uint64_t TrackQueue::GetInputSize64() {
+    mMutex.Lock();
+    const Track& last = mTracks.back();
+    uint64_t size = (last.size == UNBOUNDED_INPUT_SIZE) ? UNBOUNDED_INPUT_SIZE : last.start + last.size;
+    mMutex.Unlock();
+    return size;
+}
+
+/* Called with mMutex held, returns mTracks.size() if no track holds offset */
+size_t TrackQueue::FindTrack(uint64_t offset) {
+    size_t i = 0;
+    while (i < mTracks.size() && !(offset >= mTracks[i].start && offset - mTracks[i].start < mTracks[i].size)) {
+        i++;
+    }
+    return i;
+}
+
+bool TrackQueue::FindTrack(uint64_t offset, Track& track) {
+    mMutex.Lock();
+    size_t i = FindTrack(offset);
+    bool found = (i < mTracks.size());
+    if (found) {
+        track = mTracks[i];
+    }
+    mMutex.Unlock();
+    return found;
+}
+
+DataSource* TrackQueue::GetTrackSource(uint64_t offset) {
+    Track track;
+    return FindTrack(offset, track) ? track.dataSource : NULL;
+}
+
+uint64_t TrackQueue::GetNextOffset() {
+    mMutex.Lock();
+    uint64_t offset = mNextOffset;
+    mMutex.Unlock();
+    return offset;
+}
+
+size_t TrackQueue::ReadData(uint8_t* buffer, size_t offset, size_t length) {
+    return ReadData64(buffer, offset, length);
+}
+
+size_t TrackQueue::ReadData64(uint8_t* buffer, uint64_t offset, size_t length) {
+    Track track;
+    if (!FindTrack(offset, track)) {
+        return 0;
+    }
+
+    /* Stop at the end of the track, the next read starts the next track */
+    uint64_t trackOffset = offset - track.start;
+    if (length > track.size - trackOffset) {
+        length = (size_t)(track.size - trackOffset);
+    }
+    size_t numBytes = track.dataSource->ReadData64(buffer, trackOffset, length);
+
+    mMutex.Lock();
+    mNextOffset = offset + numBytes;
+    mMutex.Unlock();
+    return numBytes;
+}
+
+size_t TrackQueue::GetDataView(const uint8_t** data, size_t offset, size_t length) {
+    /* Held before the view is taken, so that the track is not released meanwhile */
+    mMutex.Lock();
+    size_t i = FindTrack(offset);
+    Track track;
+    bool found = (i < mTracks.size());
+    if (found) {
+        mTracks[i].numViews++;
+        track = mTracks[i];
+    }
+    mMutex.Unlock();
+    if (!found) {
+        *data = NULL;
+        return 0;
+    }
+
+    uint64_t trackOffset = offset - track.start;
+    size_t numBytes = 0;
+    *data = NULL;
+    if ((size_t)trackOffset == trackOffset) {
+        if (length > track.size - trackOffset) {
+            length = (size_t)(track.size - trackOffset);
+        }
+        numBytes = track.dataSource->GetDataView(data, (size_t)trackOffset, length);
+    }
+    if (numBytes == 0) {
+        ReleaseDataView(offset);
+    }
+    return numBytes;
+}
+
+void TrackQueue::ReleaseDataView(uint64_t offset) {
+    mMutex.Lock();
+    size_t i = FindTrack(offset);
+    if (i < mTracks.size() && mTracks[i].numViews > 0) {
+        mTracks[i].numViews--;
+    }
+    mMutex.Unlock();
+}
+
+bool TrackQueue::IsSeekable() {
+    bool seekable = true;
+    mMutex.Lock();
+    for (size_t i = 0; i < mTracks.size(); i++) {
+        seekable = seekable && mTracks[i].dataSource->IsSeekable();
+    }
+    mMutex.Unlock();
+    return seekable;
+}
+
+bool TrackQueue::IsDataReady(uint64_t offset) {
+    DataSource* dataSource = GetTrackSource(offset);
+    return dataSource == NULL || dataSource->IsDataReady();
+}
+
+qcc::Event* TrackQueue::GetDataReadyEvent(uint64_t offset) {
+    DataSource* dataSource = GetTrackSource(offset);
+    return (dataSource != NULL) ? dataSource->GetDataReadyEvent() : NULL;
+}
+
+bool TrackQueue::IsDataReady() {
+    return IsDataReady(GetNextOffset());
+}
+
+bool TrackQueue::WaitForDataReady(uint32_t timeout) {
+    DataSource* dataSource = GetTrackSource(GetNextOffset());
+    return dataSource == NULL || dataSource->WaitForDataReady(timeout);
+}
+
+qcc::Event* TrackQueue::GetDataReadyEvent() {
+    return GetDataReadyEvent(GetNextOffset());
+}
+
+}
+}
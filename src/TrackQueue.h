@@ -0,0 +1,168 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _TRACKQUEUE_H
+#define _TRACKQUEUE_H
+
+#ifndef __cplusplus
+#error Only include TrackQueue.h in C++ code.
+#endif
+
+#include <alljoyn/audio/DataSource.h>
+#include <qcc/Mutex.h>
+#include <vector>
+
+namespace ajn {
+namespace services {
+
+/**
+ * Data sources of the same format played back to back as one.
+ *
+ * Nothing can follow a track without an end.
+ *
+ * Reads never cross from one track into the next, so the packet that
+ * starts a track always starts at the offset where the previous track
+ * ended and can be encoded before the previous track is done.
+ *
+ * Offsets are kept when played tracks are released, so the queue then
+ * starts part way in.  A track is not released while a view into it
+ * is held.
+ */
+class TrackQueue : public DataSource {
+  public:
+    /**
+     * The constructor.
+     *
+     * @param[in] dataSource the first track, which sets the format.
+     */
+    TrackQueue(DataSource* dataSource);
+
+    /**
+     * Checks if a data source has the format of the queue.
+     *
+     * @param[in] dataSource the data source.
+     *
+     * @return true if dataSource can be appended.
+     */
+    bool IsCompatible(DataSource* dataSource);
+
+    /**
+     * Adds a track to the end of the queue.
+     *
+     * @param[in] dataSource the data source.
+     * @param[out] start the offset of the new track in the queue.
+     *
+     * @return false if dataSource has a different format, or the last
+     *         track has no end.
+     */
+    bool Append(DataSource* dataSource, uint64_t& start);
+
+    /**
+     * Drops the tracks that end at or before an offset.  The last track
+     * is always kept, and so is a track with a view still held, along
+     * with those after it.
+     *
+     * @param[in] offset the offset that nothing will read before again.
+     * @param[out] dataSources receives the data sources of the dropped
+     *                         tracks.
+     */
+    void Release(uint64_t offset, std::vector<DataSource*>& dataSources);
+
+    /**
+     * @param[out] dataSources receives the data sources of every track.
+     */
+    void GetDataSources(std::vector<DataSource*>& dataSources);
+
+    /**
+     * @return the number of tracks in the queue.
+     */
+    size_t GetTrackCount();
+
+    /**
+     * @return the offset of the first track still in the queue.
+     */
+    uint64_t GetStart();
+
+    /**
+     * Drops a view returned by GetDataView(), so that its track can be
+     * released.
+     *
+     * @param[in] offset the offset the view was taken at.
+     */
+    void ReleaseDataView(uint64_t offset);
+
+    /**
+     * @param[in] offset the offset of the next read.
+     *
+     * @return true if the track that holds offset has data ready, or no
+     *         track holds it so a read returns at once.
+     */
+    bool IsDataReady(uint64_t offset);
+
+    /**
+     * @param[in] offset the offset of the next read.
+     *
+     * @return the data ready event of the track that holds offset, or
+     *         NULL if it cannot signal.
+     */
+    qcc::Event* GetDataReadyEvent(uint64_t offset);
+
+    double GetSampleRate() { return mSampleRate; }
+    uint32_t GetBytesPerFrame() { return mBytesPerFrame; }
+    uint32_t GetChannelsPerFrame() { return mChannelsPerFrame; }
+    uint32_t GetBitsPerChannel() { return mBitsPerChannel; }
+    uint32_t GetInputSize();
+    uint64_t GetInputSize64();
+    size_t ReadData(uint8_t* buffer, size_t offset, size_t length);
+    size_t ReadData64(uint8_t* buffer, uint64_t offset, size_t length);
+    /**
+     * Gets a view into the track that holds offset.  The track is kept
+     * until the view is dropped with ReleaseDataView().
+     */
+    size_t GetDataView(const uint8_t** data, size_t offset, size_t length);
+    bool IsSeekable();
+    /* These ask the track that holds the offset after the last read */
+    bool IsDataReady();
+    bool WaitForDataReady(uint32_t timeout);
+    qcc::Event* GetDataReadyEvent();
+
+  private:
+    struct Track {
+        DataSource* dataSource;
+        uint64_t start;
+        uint64_t size; /* UNBOUNDED_INPUT_SIZE for a track without an end */
+        size_t numViews; /* Views into the track still held */
+    };
+
+    size_t FindTrack(uint64_t offset);
+    bool FindTrack(uint64_t offset, Track& track);
+    DataSource* GetTrackSource(uint64_t offset);
+    uint64_t GetNextOffset();
+
+    /* The format of every track, set by the first one */
+    double mSampleRate;
+    uint32_t mBytesPerFrame;
+    uint32_t mChannelsPerFrame;
+    uint32_t mBitsPerChannel;
+    qcc::Mutex mMutex;
+    std::vector<Track> mTracks;
+    uint64_t mNextOffset; /* The offset after the last read, which IsDataReady() asks about */
+};
+
+}
+}
+
+#endif /* _TRACKQUEUE_H */
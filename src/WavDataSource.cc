@@ -23,6 +23,11 @@
 
 #include <qcc/Debug.h>
 #include <qcc/Util.h>
+#include <string.h>
+#if defined(QCC_OS_GROUP_POSIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define QCC_MODULE "ALLJOYN_AUDIO"
 
@@ -39,7 +44,8 @@
 namespace ajn {
 namespace services {
 
-WavDataSource::WavDataSource() : DataSource(), mInputFileMutex(new qcc::Mutex()), mInputFile(NULL) {
+WavDataSource::WavDataSource() : DataSource(), mInputFileMutex(new qcc::Mutex()), mInputFile(NULL),
+    mMappedData(NULL), mMappedSize(0) {
 }
 
 WavDataSource::~WavDataSource() {
@@ -73,6 +79,8 @@ bool WavDataSource::Open(FILE* inputFile) {
         Close();
         return false;
     }
+
+    MapInput();
     return true;
 }
 
@@ -92,6 +100,7 @@ bool WavDataSource::Open(const char* filePath) {
 }
 
 void WavDataSource::Close() {
+    UnmapInput();
     if (mInputFile != NULL) {
         fclose(mInputFile);
         mInputFile = NULL;
@@ -145,7 +154,60 @@ bool WavDataSource::ReadHeader() {
     return false;
 }
 
+void WavDataSource::MapInput() {
+#if defined(QCC_OS_GROUP_POSIX)
+    struct stat st;
+    if (fstat(fileno(mInputFile), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        return;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(mInputFile), 0);
+    if (data == MAP_FAILED) {
+        QCC_DbgHLPrintf(("mmap failed, reading file on demand"));
+        return;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    mMappedData = (const uint8_t*)data;
+    mMappedSize = st.st_size;
+
+    /* Don't trust a data chunk size that runs past the end of the file */
+    if (mInputDataStart + mInputSize > mMappedSize) {
+        mInputSize = (mInputDataStart < mMappedSize) ? mMappedSize - mInputDataStart : 0;
+    }
+#endif
+}
+
+void WavDataSource::UnmapInput() {
+#if defined(QCC_OS_GROUP_POSIX)
+    if (mMappedData != NULL) {
+        munmap((void*)mMappedData, mMappedSize);
+        mMappedData = NULL;
+        mMappedSize = 0;
+    }
+#endif
+}
+
+size_t WavDataSource::GetDataView(const uint8_t** data, size_t offset, size_t length) {
+    if (mMappedData == NULL || offset >= mInputSize) {
+        *data = NULL;
+        return 0;
+    }
+
+    *data = mMappedData + mInputDataStart + offset;
+    return MIN(mInputSize - offset, length);
+}
+
 size_t WavDataSource::ReadData(uint8_t* buffer, size_t offset, size_t length) {
+    if (mMappedData != NULL) {
+        const uint8_t* data = NULL;
+        size_t r = GetDataView(&data, offset, length);
+        if (r > 0) {
+            memcpy(buffer, data, r);
+        }
+        return r;
+    }
+
     mInputFileMutex->Lock();
     size_t r = 0;
     if (mInputFile) {
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "WorkerPool.h"
+
+#include <qcc/Debug.h>
+
+#define QCC_MODULE "ALLJOYN_AUDIO"
+
+using namespace qcc;
+
+namespace ajn {
+namespace services {
+
+WorkerPool::WorkerPool(const char* name, size_t numWorkers) : mStopping(false) {
+    for (size_t i = 0; i < numWorkers; i++) {
+        Thread* t = new Thread(name, &WorkerThread);
+        mWorkers.push_back(t);
+        QStatus status = t->Start(this);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to start %s worker", name));
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    mMutex.Lock();
+    mStopping = true;
+    mJobEvent.SetEvent();
+    mMutex.Unlock();
+
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        mWorkers[i]->Join();
+        delete mWorkers[i];
+    }
+    mWorkers.clear();
+}
+
+QStatus WorkerPool::Execute(ThreadFunction func, void* arg, const void* owner) {
+    mMutex.Lock();
+    if (mStopping) {
+        mMutex.Unlock();
+        return ER_FAIL;
+    }
+    Job job;
+    job.func = func;
+    job.arg = arg;
+    job.owner = owner;
+    mJobs.push_back(job);
+    mPendingJobs[owner]++;
+    mJobEvent.SetEvent();
+    mMutex.Unlock();
+    return ER_OK;
+}
+
+void WorkerPool::Wait(const void* owner) {
+    mMutex.Lock();
+    while (mPendingJobs.count(owner) > 0) {
+        mJobDoneEvent.ResetEvent();
+        mMutex.Unlock();
+        Event::Wait(mJobDoneEvent);
+        mMutex.Lock();
+    }
+    mMutex.Unlock();
+}
+
+ThreadReturn WorkerPool::WorkerThread(void* arg) {
+    WorkerPool* pool = reinterpret_cast<WorkerPool*>(arg);
+
+    pool->mMutex.Lock();
+    while (true) {
+        if (pool->mJobs.empty()) {
+            if (pool->mStopping) {
+                break;
+            }
+            pool->mJobEvent.ResetEvent();
+            pool->mMutex.Unlock();
+            Event::Wait(pool->mJobEvent);
+            pool->mMutex.Lock();
+            continue;
+        }
+
+        Job job = pool->mJobs.front();
+        pool->mJobs.pop_front();
+        pool->mMutex.Unlock();
+        job.func(job.arg);
+        pool->mMutex.Lock();
+
+        if (--pool->mPendingJobs[job.owner] == 0) {
+            pool->mPendingJobs.erase(job.owner);
+            pool->mJobDoneEvent.SetEvent();
+        }
+    }
+    pool->mMutex.Unlock();
+
+    return NULL;
+}
+
+}
+}
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * A fixed set of threads that run queued jobs.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef _WORKERPOOL_H
+#define _WORKERPOOL_H
+
+#ifndef __cplusplus
+#error Only include WorkerPool.h in C++ code.
+#endif
+
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ajn {
+namespace services {
+
+/**
+ * A fixed set of threads that run queued jobs in order of submission.
+ */
+class WorkerPool {
+  public:
+    /**
+     * The constructor.
+     *
+     * @param[in] name the name given to the worker threads.
+     * @param[in] numWorkers the number of worker threads.
+     */
+    WorkerPool(const char* name, size_t numWorkers);
+
+    /**
+     * The destructor runs any queued jobs before stopping the workers.
+     */
+    ~WorkerPool();
+
+    /**
+     * Queues a job to run on the next free worker.
+     *
+     * @param[in] func the function to run.
+     * @param[in] arg the argument passed to func.
+     * @param[in] owner identifies the jobs that Wait() waits for.
+     *
+     * @return ER_OK, or ER_FAIL if the pool is being destroyed.
+     */
+    QStatus Execute(qcc::ThreadFunction func, void* arg, const void* owner = NULL);
+
+    /**
+     * Waits until every job queued by an owner has run, including jobs
+     * those jobs queued.  Must not be called from a job.
+     *
+     * @param[in] owner the owner passed to Execute().
+     */
+    void Wait(const void* owner);
+
+  private:
+    static qcc::ThreadReturn WorkerThread(void* arg);
+
+    struct Job {
+        qcc::ThreadFunction func;
+        void* arg;
+        const void* owner;
+    };
+
+    qcc::Mutex mMutex;
+    qcc::Event mJobEvent;
+    qcc::Event mJobDoneEvent;
+    std::list<Job> mJobs;
+    std::map<const void*, size_t> mPendingJobs; /* Queued and running jobs per owner */
+    std::vector<qcc::Thread*> mWorkers;
+    bool mStopping;
+};
+
+}
+}
+
+#endif /* _WORKERPOOL_H */
@@ -136,7 +136,7 @@ void AlacDecoder::Decode(uint8_t** buffer, uint32_t* numBytes) {
 }
 
 AlacEncoder::AlacEncoder() :
-    mEncoder(NULL), mEncodeBuffer(NULL) {
+    mEncoder(NULL), mEncodeBuffer(NULL), mFramesPerPacket(FRAMES_PER_PACKET) {
 }
 
 AlacEncoder::~AlacEncoder() {
@@ -164,7 +164,7 @@ QStatus AlacEncoder::Configure(DataSource* dataSource) {
     mOutputFormat.mFormatID = kALACFormatAppleLossless;
     mOutputFormat.mSampleRate = dataSource->GetSampleRate();
     mOutputFormat.mFormatFlags = kTestFormatFlag_16BitSourceData;
-    mOutputFormat.mFramesPerPacket = FRAMES_PER_PACKET;
+    mOutputFormat.mFramesPerPacket = mFramesPerPacket;
     mOutputFormat.mChannelsPerFrame = dataSource->GetChannelsPerFrame();
     // mBytesPerPacket == 0 because we are VBR
     // mBytesPerFrame and mBitsPerChannel == 0 because there are no discernable bits assigned to a particular sample
@@ -180,6 +180,14 @@ QStatus AlacEncoder::Configure(DataSource* dataSource) {
     return ER_OK;
 }
 
+bool AlacEncoder::SetFrameSize(uint32_t framesPerPacket) {
+    if (mEncoder != NULL || framesPerPacket == 0 || framesPerPacket > FRAMES_PER_PACKET) {
+        return false;
+    }
+    mFramesPerPacket = framesPerPacket;
+    return true;
+}
+
 void AlacEncoder::GetConfiguration(Capability* configuration) {
     configuration->type = MIMETYPE_AUDIO_ALAC;
     configuration->numParameters = 5;
@@ -72,6 +72,7 @@ class AlacEncoder : public AudioEncoder {
     ~AlacEncoder();
 
     QStatus Configure(DataSource* dataSource);
+    bool SetFrameSize(uint32_t framesPerPacket);
     uint32_t GetFrameSize() const { return mOutputFormat.mFramesPerPacket; }
     void GetConfiguration(Capability* configuration);
     void Encode(uint8_t** buffer, uint32_t* numBytes);
@@ -81,6 +82,7 @@ class AlacEncoder : public AudioEncoder {
     AudioFormatDescription mInputFormat;
     AudioFormatDescription mOutputFormat;
     uint8_t* mEncodeBuffer;
+    uint32_t mFramesPerPacket;
 };
 
 }
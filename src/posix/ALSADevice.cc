@@ -46,7 +46,7 @@ ALSADevice::ALSADevice(const char* deviceName, const char* mixerName)
     : mAudioDeviceName(deviceName), mAudioMixerName(mixerName),
     mMutex(new qcc::Mutex()), mMute(false), mVolume(LONG_MAX), mVolumeScale(1.0), mVolumeOffset(0),
     mAudioDeviceHandle(NULL), mAudioMixerHandle(NULL),
-    mAudioMixerElementMaster(NULL), mAudioMixerElementPCM(NULL), mAudioMixerThread(NULL),
+    mAudioMixerElementMaster(NULL), mAudioMixerElementPCM(NULL), mBufferTarget(0), mAudioMixerThread(NULL),
     mListenersMutex(new qcc::Mutex()) {
 }
 
@@ -129,9 +129,23 @@ bool ALSADevice::Open(const char* format, uint32_t sampleRate, uint32_t numChann
     }
 
     uint32_t bytesPerFrame = (bitsPerChannel >> 3) * numChannels;
-    snd_pcm_uframes_t bs = 4096 * bytesPerFrame;
-    if ((err = snd_pcm_hw_params_set_buffer_size(mAudioDeviceHandle, hw_params, bs)) < 0) {
-        QCC_LogError(ER_OS_ERROR, ("snd_pcm_hw_params_set_buffer_size failed: %s", snd_strerror(err)));
+    snd_pcm_uframes_t bs;
+    if (mBufferTarget == 0) {
+        bs = 4096 * bytesPerFrame;
+        if ((err = snd_pcm_hw_params_set_buffer_size(mAudioDeviceHandle, hw_params, bs)) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("snd_pcm_hw_params_set_buffer_size failed: %s", snd_strerror(err)));
+        }
+    } else {
+        /* A small buffer needs several periods so that it can be refilled before it runs dry */
+        bs = mBufferTarget;
+        if ((err = snd_pcm_hw_params_set_buffer_size_near(mAudioDeviceHandle, hw_params, &bs)) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("snd_pcm_hw_params_set_buffer_size_near failed: %s", snd_strerror(err)));
+        }
+        snd_pcm_uframes_t ps = bs / 4;
+        int dir = 0;
+        if ((err = snd_pcm_hw_params_set_period_size_near(mAudioDeviceHandle, hw_params, &ps, &dir)) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("snd_pcm_hw_params_set_period_size_near failed: %s", snd_strerror(err)));
+        }
     }
 
     if ((err = snd_pcm_hw_params(mAudioDeviceHandle, hw_params)) < 0) {
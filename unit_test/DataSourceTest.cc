@@ -0,0 +1,396 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "Clock.h"
+#include "TrackQueue.h"
+#include <alljoyn/audio/PrefetchDataSource.h>
+#include <alljoyn/audio/StreamingDataSource.h>
+#include "gtest/gtest.h"
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <vector>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+using namespace ajn::services;
+using namespace qcc;
+using namespace std;
+
+/* Each byte holds the low bits of its offset, so that a read shows where it came from */
+static bool IsPattern(const uint8_t* buffer, uint64_t offset, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (buffer[i] != (uint8_t)(offset + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class PatternDataSource : public DataSource {
+  public:
+    PatternDataSource(uint64_t size, double sampleRate = 44100) : mSize(size), mSampleRate(sampleRate) { }
+
+    double GetSampleRate() { return mSampleRate; }
+    uint32_t GetBytesPerFrame() { return 4; }
+    uint32_t GetChannelsPerFrame() { return 2; }
+    uint32_t GetBitsPerChannel() { return 16; }
+    uint32_t GetInputSize() { return (uint32_t)MIN(mSize, (uint64_t)0xFFFFFFFF); }
+    uint64_t GetInputSize64() { return mSize; }
+    bool IsDataReady() { return true; }
+
+    size_t ReadData(uint8_t* buffer, size_t offset, size_t length) {
+        return ReadData64(buffer, offset, length);
+    }
+
+    size_t ReadData64(uint8_t* buffer, uint64_t offset, size_t length) {
+        if (offset >= mSize) {
+            return 0;
+        }
+        length = (size_t)MIN((uint64_t)length, mSize - offset);
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = (uint8_t)(offset + i);
+        }
+        return length;
+    }
+
+  private:
+    uint64_t mSize;
+    double mSampleRate;
+};
+
+/* Has no data until opened, like live input that has not started */
+class GatedDataSource : public PatternDataSource {
+  public:
+    GatedDataSource(bool signals) : PatternDataSource(1024 * 1024), mSignals(signals), mOpen(false), mChecks(0) { }
+
+    void Open() {
+        mMutex.Lock();
+        mOpen = true;
+        mDataReadyEvent.SetEvent();
+        mMutex.Unlock();
+    }
+
+    bool IsDataReady() {
+        mMutex.Lock();
+        mChecks++;
+        bool ready = mOpen;
+        mMutex.Unlock();
+        return ready;
+    }
+
+    Event* GetDataReadyEvent() { return mSignals ? &mDataReadyEvent : NULL; }
+
+    size_t GetCheckCount() {
+        mMutex.Lock();
+        size_t checks = mChecks;
+        mMutex.Unlock();
+        return checks;
+    }
+
+  private:
+    bool mSignals;
+    Mutex mMutex;
+    bool mOpen;
+    size_t mChecks;
+    Event mDataReadyEvent;
+};
+
+static ThreadReturn OpenGateThread(void* arg) {
+    Thread::Sleep(100);
+    reinterpret_cast<GatedDataSource*>(arg)->Open();
+    return 0;
+}
+
+class PatternStream : public StreamingDataSource {
+  public:
+    PatternStream(uint32_t historyMs) : StreamingDataSource(historyMs), mOffset(0) { }
+
+    double GetSampleRate() { return 44100; }
+    uint32_t GetBytesPerFrame() { return 4; }
+    uint32_t GetChannelsPerFrame() { return 2; }
+    uint32_t GetBitsPerChannel() { return 16; }
+    bool IsDataReady() { return true; }
+
+    size_t ReadStream(uint8_t* buffer, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = (uint8_t)(mOffset + i);
+        }
+        mOffset += length;
+        return length;
+    }
+
+  private:
+    uint64_t mOffset;
+};
+
+TEST(DataSourceTest, TrackQueueReadStopsAtTrackBoundary) {
+    PatternDataSource first(1000);
+    PatternDataSource second(2000);
+    TrackQueue queue(&first);
+    uint64_t start = 0;
+    ASSERT_TRUE(queue.Append(&second, start));
+    EXPECT_EQ(1000U, start);
+    EXPECT_EQ(3000U, queue.GetInputSize64());
+    EXPECT_EQ(2U, queue.GetTrackCount());
+
+    /* A read never crosses into the next track */
+    uint8_t buffer[256];
+    EXPECT_EQ(100U, queue.ReadData64(buffer, 900, sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, 900, 100));
+
+    /* The next track is read from its own start */
+    EXPECT_EQ(sizeof(buffer), queue.ReadData64(buffer, 1000, sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, 0, sizeof(buffer)));
+    EXPECT_EQ(56U, queue.ReadData64(buffer, 2944, sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, 1944, 56));
+    EXPECT_EQ(0U, queue.ReadData64(buffer, 3000, sizeof(buffer)));
+}
+
+TEST(DataSourceTest, TrackQueueAppendChecks) {
+    PatternDataSource first(1000);
+    PatternDataSource otherRate(1000, 48000);
+    PatternDataSource unbounded(DataSource::UNBOUNDED_INPUT_SIZE);
+    PatternDataSource last(1000);
+    TrackQueue queue(&first);
+    uint64_t start = 0;
+    EXPECT_FALSE(queue.Append(&otherRate, start));
+
+    /* Nothing can follow a track without an end */
+    ASSERT_TRUE(queue.Append(&unbounded, start));
+    EXPECT_EQ(DataSource::UNBOUNDED_INPUT_SIZE, queue.GetInputSize64());
+    EXPECT_FALSE(queue.Append(&last, start));
+}
+
+TEST(DataSourceTest, TrackQueueRelease) {
+    PatternDataSource first(1000);
+    PatternDataSource second(1000);
+    PatternDataSource third(1000);
+    TrackQueue queue(&first);
+    uint64_t start = 0;
+    ASSERT_TRUE(queue.Append(&second, start));
+    ASSERT_TRUE(queue.Append(&third, start));
+
+    vector<DataSource*> released;
+    queue.Release(999, released);
+    EXPECT_TRUE(released.empty());
+    EXPECT_EQ(3U, queue.GetTrackCount());
+
+    queue.Release(1500, released);
+    ASSERT_EQ(1U, released.size());
+    EXPECT_EQ(&first, released[0]);
+    EXPECT_EQ(1000U, queue.GetStart());
+
+    /* Offsets are kept, and released data can't be read again */
+    uint8_t buffer[16];
+    EXPECT_EQ(0U, queue.ReadData64(buffer, 500, sizeof(buffer)));
+    EXPECT_EQ(sizeof(buffer), queue.ReadData64(buffer, 2000, sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, 0, sizeof(buffer)));
+
+    /* The last track is always kept */
+    released.clear();
+    queue.Release(3000, released);
+    ASSERT_EQ(1U, released.size());
+    EXPECT_EQ(&second, released[0]);
+    EXPECT_EQ(1U, queue.GetTrackCount());
+    EXPECT_EQ(2000U, queue.GetStart());
+    EXPECT_EQ(3000U, queue.GetInputSize64());
+
+    released.clear();
+    queue.GetDataSources(released);
+    ASSERT_EQ(1U, released.size());
+    EXPECT_EQ(&third, released[0]);
+}
+
+TEST(DataSourceTest, TrackQueueAsksTheTrackAtOffset) {
+    PatternDataSource first(1000);
+    GatedDataSource second(true);
+    TrackQueue queue(&first);
+    uint64_t start = 0;
+    ASSERT_TRUE(queue.Append(&second, start));
+
+    /* The next track is asked while the first is still being read */
+    uint8_t buffer[256];
+    ASSERT_EQ(sizeof(buffer), queue.ReadData64(buffer, 0, sizeof(buffer)));
+    EXPECT_TRUE(queue.IsDataReady(0));
+    EXPECT_FALSE(queue.IsDataReady(1000));
+    EXPECT_TRUE(queue.GetDataReadyEvent(0) == NULL);
+    EXPECT_EQ(second.GetDataReadyEvent(), queue.GetDataReadyEvent(1000));
+
+    /* Without an offset, the track after the last read is asked */
+    EXPECT_TRUE(queue.IsDataReady());
+    ASSERT_EQ(232U, queue.ReadData64(buffer, 768, sizeof(buffer)));
+    EXPECT_FALSE(queue.IsDataReady());
+    second.Open();
+    EXPECT_TRUE(queue.IsDataReady(1000));
+    EXPECT_TRUE(queue.IsDataReady());
+}
+
+/* Gives out views, like a mapped file, and counts them */
+class ViewDataSource : public PatternDataSource {
+  public:
+    ViewDataSource(uint64_t size) : PatternDataSource(size), mViews(0) { }
+
+    size_t GetDataView(const uint8_t** data, size_t offset, size_t length) {
+        static const uint8_t view[16] = { 0 };
+        *data = view;
+        mViews++;
+        return MIN(length, sizeof(view));
+    }
+
+    size_t mViews;
+};
+
+TEST(DataSourceTest, TrackQueueKeepsTracksWithViews) {
+    ViewDataSource first(1000);
+    PatternDataSource second(1000);
+    TrackQueue queue(&first);
+    uint64_t start = 0;
+    ASSERT_TRUE(queue.Append(&second, start));
+
+    const uint8_t* view = NULL;
+    ASSERT_EQ(16U, queue.GetDataView(&view, 500, 100));
+    EXPECT_EQ(1U, first.mViews);
+
+    /* Played, but still pointed into */
+    vector<DataSource*> released;
+    queue.Release(1500, released);
+    EXPECT_TRUE(released.empty());
+    EXPECT_EQ(2U, queue.GetTrackCount());
+
+    queue.ReleaseDataView(500);
+    queue.Release(1500, released);
+    ASSERT_EQ(1U, released.size());
+    EXPECT_EQ(&first, released[0]);
+
+    /* A track that gives no view is not held */
+    EXPECT_EQ(0U, queue.GetDataView(&view, 1500, 100));
+    EXPECT_TRUE(view == NULL);
+}
+
+TEST(DataSourceTest, PrefetchRingWraps) {
+    /* The ring holds 128KB, so this reads around it several times */
+    PatternDataSource source(1024 * 1024);
+    PrefetchDataSource prefetch(&source, 100);
+    EXPECT_EQ(source.GetInputSize64(), prefetch.GetInputSize64());
+
+    uint8_t buffer[4096];
+    uint64_t offset = 0;
+    while (offset < 512 * 1024) {
+        size_t numBytes = prefetch.ReadData64(buffer, offset, sizeof(buffer));
+        ASSERT_GT(numBytes, 0U);
+        ASSERT_TRUE(IsPattern(buffer, offset, numBytes));
+        offset += numBytes;
+    }
+    EXPECT_GT(prefetch.GetHitCount(), 0U);
+}
+
+TEST(DataSourceTest, PrefetchRestarts) {
+    PatternDataSource source(1024 * 1024);
+    PrefetchDataSource prefetch(&source, 100);
+
+    uint8_t buffer[4096];
+    ASSERT_GT(prefetch.ReadData64(buffer, 0, sizeof(buffer)), 0U);
+
+    /* Far ahead of the ring, then back before it */
+    size_t numBytes = prefetch.ReadData64(buffer, 900000, sizeof(buffer));
+    ASSERT_GT(numBytes, 0U);
+    EXPECT_TRUE(IsPattern(buffer, 900000, numBytes));
+    numBytes = prefetch.ReadData64(buffer, 100, sizeof(buffer));
+    ASSERT_GT(numBytes, 0U);
+    EXPECT_TRUE(IsPattern(buffer, 100, numBytes));
+
+    /* Reads at the end are short, and past it empty */
+    numBytes = prefetch.ReadData64(buffer, source.GetInputSize64() - 10, sizeof(buffer));
+    EXPECT_EQ(10U, numBytes);
+    EXPECT_TRUE(IsPattern(buffer, source.GetInputSize64() - 10, numBytes));
+    EXPECT_EQ(0U, prefetch.ReadData64(buffer, source.GetInputSize64(), sizeof(buffer)));
+}
+
+TEST(DataSourceTest, StreamingIsUnbounded) {
+    PatternStream stream(100);
+    EXPECT_EQ(DataSource::UNBOUNDED_INPUT_SIZE, stream.GetInputSize64());
+    EXPECT_EQ(0xFFFFFFFFU, stream.GetInputSize());
+    EXPECT_FALSE(stream.IsSeekable());
+
+    /* Reading ahead reads the stream on */
+    uint8_t buffer[4096];
+    EXPECT_EQ(sizeof(buffer), stream.ReadData64(buffer, 10000, sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, 10000, sizeof(buffer)));
+}
+
+TEST(DataSourceTest, StreamingRefusesSeekBeforeHistory) {
+    /* The history is at least 64KB */
+    PatternStream stream(100);
+    uint8_t buffer[4096];
+    uint64_t offset = 0;
+    while (offset < 256 * 1024) {
+        ASSERT_EQ(sizeof(buffer), stream.ReadData64(buffer, offset, sizeof(buffer)));
+        ASSERT_TRUE(IsPattern(buffer, offset, sizeof(buffer)));
+        offset += sizeof(buffer);
+    }
+
+    /* Recent data is read again, older data is gone */
+    EXPECT_EQ(sizeof(buffer), stream.ReadData64(buffer, offset - 2 * sizeof(buffer), sizeof(buffer)));
+    EXPECT_TRUE(IsPattern(buffer, offset - 2 * sizeof(buffer), sizeof(buffer)));
+    EXPECT_EQ(0U, stream.ReadData64(buffer, 0, sizeof(buffer)));
+}
+
+TEST(DataSourceTest, WaitForDataReadyWakesOnTheEvent) {
+    GatedDataSource source(true);
+    Thread opener("Opener", &OpenGateThread);
+    opener.Start(&source);
+
+    /* Checked before and after the wait rather than every few ms */
+    uint64_t start = GetCurrentTimeNanos();
+    EXPECT_TRUE(source.WaitForDataReady(5000));
+    uint64_t waited = GetCurrentTimeNanos() - start;
+    opener.Join();
+    EXPECT_GE(waited, 90000000U);
+    EXPECT_LT(waited, 1000000000U);
+    EXPECT_LE(source.GetCheckCount(), 3U);
+}
+
+TEST(DataSourceTest, WaitForDataReadyPollsWithoutAnEvent) {
+    GatedDataSource source(false);
+    EXPECT_FALSE(source.WaitForDataReady(100));
+    EXPECT_GT(source.GetCheckCount(), 3U);
+
+    source.Open();
+    EXPECT_TRUE(source.WaitForDataReady(100));
+}
+
+TEST(DataSourceTest, PrefetchSignalsDataReady) {
+    GatedDataSource source(true);
+    PrefetchDataSource prefetch(&source, 100);
+    Event* dataReadyEvent = prefetch.GetDataReadyEvent();
+    ASSERT_TRUE(dataReadyEvent != NULL);
+
+    /* The prefetch thread blocks on the source rather than polling it */
+    Thread::Sleep(100);
+    EXPECT_FALSE(prefetch.IsDataReady());
+    EXPECT_NE(ER_OK, Event::Wait(*dataReadyEvent, 0));
+    EXPECT_LE(source.GetCheckCount(), 3U);
+
+    source.Open();
+    EXPECT_EQ(ER_OK, Event::Wait(*dataReadyEvent, 2000));
+    EXPECT_TRUE(prefetch.IsDataReady());
+
+    uint8_t buffer[4096];
+    size_t numBytes = prefetch.ReadData64(buffer, 0, sizeof(buffer));
+    ASSERT_GT(numBytes, 0U);
+    EXPECT_TRUE(IsPattern(buffer, 0, numBytes));
+}
@@ -48,6 +48,13 @@ class TestFixture {
         }
     };
 
+    class TestSessionPortListener : public SessionPortListener {
+      public:
+        bool AcceptSessionJoiner(SessionPort sessionPort, const char* joiner, const SessionOpts& opts) {
+            return true;
+        }
+    };
+
     BusAttachment* mMsgBus;
     bool mJoinComplete;
     char* mServiceName;
@@ -55,6 +62,7 @@ class TestFixture {
     char* mStreamObjectPath;
     volatile sig_atomic_t mInterrupt;
     TestSessionListener* mSessionListener;
+    TestSessionPortListener* mSessionPortListener;
     const char* connectArgs;
     TestSignalHandler* signalHandler;
 
@@ -69,6 +77,7 @@ class TestFixture {
         connectArgs = NULL;
 
         mSessionListener = new TestSessionListener(this);
+        mSessionPortListener = new TestSessionPortListener();
         signalHandler = NULL;
 
         InitStream();
@@ -89,6 +98,9 @@ class TestFixture {
         delete mSessionListener;
         mSessionListener = NULL;
 
+        delete mSessionPortListener;
+        mSessionPortListener = NULL;
+
         if (signalHandler != NULL) {
             delete signalHandler;
             signalHandler = NULL;
@@ -243,6 +255,27 @@ class TestFixture {
         capability.parameters[2].Set("{sv}", "Format", formatArg);
     }
 
+    void AddStringParameter(Capability& capability, const char* name, const char* value) {
+
+        MsgArg valueArg("s", value);
+        MsgArg* parameters = new MsgArg[capability.numParameters + 1];
+        for (size_t i = 0; i < capability.numParameters; i++)
+            parameters[i] = capability.parameters[i];
+        parameters[capability.numParameters].Set("{sv}", name, &valueArg);
+        parameters[capability.numParameters].Stabilize();
+        delete [] capability.parameters;
+        capability.parameters = parameters;
+        capability.numParameters++;
+    }
+
+    void SetCreditFlowControl(Capability& capability) {
+        AddStringParameter(capability, FLOW_CONTROL_PARAMETER, FLOW_CONTROL_CREDIT);
+    }
+
+    void SetLatencyProfile(Capability& capability, const char* profile) {
+        AddStringParameter(capability, LATENCY_PROFILE_PARAMETER, profile);
+    }
+
     QStatus ConfigurePort(ProxyBusObject* port, Capability* capability) {
         Message reply(*mMsgBus);
         MsgArg connectArgs[3];
@@ -362,6 +395,27 @@ class TestFixture {
         return ER_TIMEOUT;
     }
 
+    QStatus WaitForFifoLevelChanged(uint32_t timeoutMs) {
+
+        printf("\t     Waiting for FifoLevelChanged event...\n");
+        uint32_t interval = 500;
+        for (uint32_t i = 0; mInterrupt == false && i < (timeoutMs / interval); i++) {
+            if (signalHandler->WaitForFifoLevelChanged(interval) == ER_OK) {
+                return ER_OK;
+            }
+        }
+        return ER_TIMEOUT;
+    }
+
+    QStatus GetFifoLevel(uint32_t& position, uint32_t& credit) {
+
+        if (signalHandler != NULL) {
+            signalHandler->GetFifoLevel(position, credit);
+            return ER_OK;
+        }
+        return ER_FAIL;
+    }
+
     QStatus GetFifoSize(ProxyBusObject* port, uint32_t& size) {
 
         size = 0;
@@ -371,6 +425,33 @@ class TestFixture {
         return reply.Get("u", &size);
     }
 
+    QStatus GetLatencyProfile(ProxyBusObject* port, String& profile) {
+
+        MsgArg reply;
+        QStatus status = port->GetProperty(AUDIO_SINK_LATENCY_INTERFACE, "LatencyProfile", reply);
+        if (status != ER_OK) { return status; }
+        char* value;
+        status = reply.Get("s", &value);
+        if (status == ER_OK) { profile = value; }
+        return status;
+    }
+
+    QStatus BindMultipointPort(SessionPort& sessionPort) {
+
+        SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, true, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+        sessionPort = SESSION_PORT_ANY;
+        return mMsgBus->BindSessionPort(sessionPort, opts, *mSessionPortListener);
+    }
+
+    QStatus JoinMultipoint(ProxyBusObject* port, SessionPort sessionPort, SessionId& sessionId) {
+
+        Message reply(*mMsgBus);
+        MsgArg portArg("q", sessionPort);
+        QStatus status = port->MethodCall(AUDIO_SINK_MULTIPOINT_INTERFACE, "Join", &portArg, 1, reply);
+        if (status != ER_OK) { return status; }
+        return reply->GetArg(0)->Get("u", &sessionId);
+    }
+
     QStatus WaitForOwnershipLost(uint32_t timeoutMs) {
 
         printf("\t     Waiting for OwnershipLost event...\n");
@@ -411,6 +492,8 @@ class StreamTest : public testing::Test {
     void SetRawCapability(Capability& capability, uint8_t channels, uint32_t sampleRate, const char* format = "s16le") {
         return mFixture->SetRawCapability(capability, channels, sampleRate, format);
     }
+    void SetCreditFlowControl(Capability& capability) { return mFixture->SetCreditFlowControl(capability); }
+    void SetLatencyProfile(Capability& capability, const char* profile) { return mFixture->SetLatencyProfile(capability, profile); }
     QStatus ConfigurePort(ProxyBusObject* port, Capability* capability) { return mFixture->ConfigurePort(port, capability); }
     QStatus SetTime(ProxyBusObject* stream) { return mFixture->SetTime(stream); }
     void RegisterSignalHandler(const char* path) { return mFixture->RegisterSignalHandler(path); }
@@ -423,7 +506,14 @@ class StreamTest : public testing::Test {
     QStatus WaitForPlayStateChanged(uint32_t timeoutMs) { return mFixture->WaitForPlayStateChanged(timeoutMs); }
     QStatus GetPlayState(uint8_t& playState) { return mFixture->GetPlayState(playState); }
     QStatus WaitForFifoPositionChanged(uint32_t timeoutMs) { return mFixture->WaitForFifoPositionChanged(timeoutMs); }
+    QStatus WaitForFifoLevelChanged(uint32_t timeoutMs) { return mFixture->WaitForFifoLevelChanged(timeoutMs); }
+    QStatus GetFifoLevel(uint32_t& position, uint32_t& credit) { return mFixture->GetFifoLevel(position, credit); }
     QStatus GetFifoSize(ProxyBusObject* port, uint32_t& size) { return mFixture->GetFifoSize(port, size); }
+    QStatus GetLatencyProfile(ProxyBusObject* port, String& profile) { return mFixture->GetLatencyProfile(port, profile); }
+    QStatus BindMultipointPort(SessionPort& sessionPort) { return mFixture->BindMultipointPort(sessionPort); }
+    QStatus JoinMultipoint(ProxyBusObject* port, SessionPort sessionPort, SessionId& sessionId) {
+        return mFixture->JoinMultipoint(port, sessionPort, sessionId);
+    }
     QStatus WaitForOwnershipLost(uint32_t timeoutMs) { return mFixture->WaitForOwnershipLost(timeoutMs); }
     QStatus GetNewOwner(String& newOwner) { return mFixture->GetNewOwner(newOwner); }
     QStatus EmitImageDataSignal(uint8_t* data, int32_t dataSize) {
@@ -917,6 +1007,135 @@ TEST_F(StreamTest, IdleFlush) {
     delete stream;
 }
 
+TEST_F(StreamTest, CreditFlowControlFlush) {
+
+    ProxyBusObject* stream = CreateStream();
+    EXPECT_EQ(OpenStream(stream), ER_OK);
+
+    ProxyBusObject* port = GetPort(stream);
+    ASSERT_TRUE(port);
+    ASSERT_TRUE(port->ImplementsInterface(AUDIO_SINK_FLOW_CONTROL_INTERFACE));
+
+    Capability capability;
+    SetRawCapability(capability, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE);
+    SetCreditFlowControl(capability);
+    EXPECT_EQ(ConfigurePort(port, &capability), ER_OK);
+    uint32_t fifoSize;
+    EXPECT_EQ(GetFifoSize(port, fifoSize), ER_OK);
+    RegisterSignalHandler(port->GetPath().c_str());
+
+    EXPECT_EQ(SendSilentAudio(fifoSize, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE), ER_OK);
+    EXPECT_EQ(WaitForPlayStateChanged(AudioTest::sTimeout), ER_OK);
+
+    EXPECT_EQ(Flush(port), ER_OK);
+    EXPECT_EQ(WaitForFifoLevelChanged(AudioTest::sTimeout), ER_OK);
+
+    uint32_t position;
+    uint32_t credit;
+    EXPECT_EQ(GetFifoLevel(position, credit), ER_OK);
+    EXPECT_EQ(position, 0U);
+    EXPECT_EQ(credit, fifoSize);
+
+    delete stream;
+}
+
+TEST_F(StreamTest, LatencyProfile) {
+
+    /* The FIFO sizes and low-water marks of AudioSinkObject */
+    const uint32_t bytesPerFrame = DEFAULT_CHANNELS * 2;
+    const uint32_t normalFifoSize = DEFAULT_SAMPLERATE * bytesPerFrame * 5;
+    const uint32_t normalThreshold = DEFAULT_SAMPLERATE * bytesPerFrame * 4;
+    const uint32_t lowFifoSize = bytesPerFrame * (DEFAULT_SAMPLERATE * 100 / 1000);
+    const uint32_t lowThreshold = bytesPerFrame * (DEFAULT_SAMPLERATE * 60 / 1000);
+
+    ProxyBusObject* stream = CreateStream();
+    EXPECT_EQ(OpenStream(stream), ER_OK);
+
+    ProxyBusObject* port = GetPort(stream);
+    ASSERT_TRUE(port);
+    ASSERT_TRUE(port->ImplementsInterface(AUDIO_SINK_LATENCY_INTERFACE));
+
+    Capability capability;
+    SetRawCapability(capability, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE);
+    SetCreditFlowControl(capability);
+    EXPECT_EQ(ConfigurePort(port, &capability), ER_OK);
+    String profile;
+    EXPECT_EQ(GetLatencyProfile(port, profile), ER_OK);
+    EXPECT_STREQ(LATENCY_PROFILE_NORMAL, profile.c_str());
+    uint32_t fifoSize;
+    EXPECT_EQ(GetFifoSize(port, fifoSize), ER_OK);
+    EXPECT_EQ(normalFifoSize, fifoSize);
+
+    /* The level is signalled once the FIFO drains to the low-water mark */
+    RegisterSignalHandler(port->GetPath().c_str());
+    EXPECT_EQ(SendSilentAudio(fifoSize, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE), ER_OK);
+    EXPECT_EQ(WaitForFifoLevelChanged(AudioTest::sTimeout), ER_OK);
+    uint32_t position;
+    uint32_t credit;
+    EXPECT_EQ(GetFifoLevel(position, credit), ER_OK);
+    EXPECT_LE(position, normalThreshold);
+    EXPECT_EQ(fifoSize - position, credit);
+    EXPECT_EQ(CloseStream(stream), ER_OK);
+    delete stream;
+
+    /* The sink may fall back to normal if its audio device can't keep up */
+    stream = CreateStream();
+    EXPECT_EQ(OpenStream(stream), ER_OK);
+    port = GetPort(stream);
+    ASSERT_TRUE(port);
+    Capability lowCapability;
+    SetRawCapability(lowCapability, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE);
+    SetCreditFlowControl(lowCapability);
+    SetLatencyProfile(lowCapability, LATENCY_PROFILE_LOW);
+    EXPECT_EQ(ConfigurePort(port, &lowCapability), ER_OK);
+    EXPECT_EQ(GetLatencyProfile(port, profile), ER_OK);
+    EXPECT_EQ(GetFifoSize(port, fifoSize), ER_OK);
+    uint32_t threshold = normalThreshold;
+    if (profile == LATENCY_PROFILE_LOW) {
+        EXPECT_EQ(lowFifoSize, fifoSize);
+        threshold = lowThreshold;
+    } else {
+        EXPECT_STREQ(LATENCY_PROFILE_NORMAL, profile.c_str());
+        EXPECT_EQ(normalFifoSize, fifoSize);
+    }
+
+    /* The reopened stream has the same port path, so the handler is still registered */
+    EXPECT_EQ(SendSilentAudio(fifoSize, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE), ER_OK);
+    EXPECT_EQ(WaitForFifoLevelChanged(AudioTest::sTimeout), ER_OK);
+    EXPECT_EQ(GetFifoLevel(position, credit), ER_OK);
+    EXPECT_LE(position, threshold);
+    EXPECT_EQ(fifoSize - position, credit);
+    EXPECT_EQ(CloseStream(stream), ER_OK);
+
+    delete stream;
+}
+
+TEST_F(StreamTest, MultipointJoin) {
+
+    ProxyBusObject* stream = CreateStream();
+    EXPECT_EQ(OpenStream(stream), ER_OK);
+
+    ProxyBusObject* port = GetPort(stream);
+    ASSERT_TRUE(port);
+    ASSERT_TRUE(port->ImplementsInterface(AUDIO_SINK_MULTIPOINT_INTERFACE));
+
+    SessionPort sessionPort;
+    ASSERT_EQ(BindMultipointPort(sessionPort), ER_OK);
+
+    /* Only a connected port can join */
+    SessionId sessionId = 0;
+    EXPECT_NE(JoinMultipoint(port, sessionPort, sessionId), ER_OK);
+
+    Capability capability;
+    SetRawCapability(capability, DEFAULT_CHANNELS, DEFAULT_SAMPLERATE);
+    EXPECT_EQ(ConfigurePort(port, &capability), ER_OK);
+    EXPECT_EQ(JoinMultipoint(port, sessionPort, sessionId), ER_OK);
+    EXPECT_NE(sessionId, 0u);
+
+    EXPECT_EQ(CloseStream(stream), ER_OK);
+    delete stream;
+}
+
 TEST_F(StreamTest, ImageTest) {
     ProxyBusObject* stream = CreateStream();
     EXPECT_EQ(ER_OK, OpenStream(stream));
@@ -974,6 +1193,12 @@ TEST_F(StreamTest, GetInterfaceVersions) {
     EXPECT_GE(version, 1);
     EXPECT_EQ(ER_OK, GetInterfaceVersion(port, AUDIO_SINK_INTERFACE, version));
     EXPECT_GE(version, 1);
+    EXPECT_EQ(ER_OK, GetInterfaceVersion(port, AUDIO_SINK_FLOW_CONTROL_INTERFACE, version));
+    EXPECT_GE(version, 1);
+    EXPECT_EQ(ER_OK, GetInterfaceVersion(port, AUDIO_SINK_LATENCY_INTERFACE, version));
+    EXPECT_GE(version, 1);
+    EXPECT_EQ(ER_OK, GetInterfaceVersion(port, AUDIO_SINK_MULTIPOINT_INTERFACE, version));
+    EXPECT_GE(version, 1);
     EXPECT_EQ(ER_OK, GetInterfaceVersion(port, VOLUME_INTERFACE, version));
     EXPECT_GE(version, 1);
 
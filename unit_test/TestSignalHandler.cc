@@ -40,10 +40,13 @@ TestSignalHandler::TestSignalHandler(BusAttachment* bus, const char* path, Sessi
     mReadyToEmitEvent = new Event();
     mPlayStateChangedEvent = new Event();
     mFifoPositionChangedEvent = new Event();
+    mFifoLevelChangedEvent = new Event();
     mMuteChangedEvent = new Event();
     mVolumeChangedEvent = new Event();
     mOwnershipLostEvent = new Event();
     mPlayState = 0;
+    mFifoPosition = 0;
+    mFifoCredit = 0;
     mMute = false;
     mVolume = INT16_MIN;
     mSessionId = sessionId;
@@ -55,6 +58,7 @@ TestSignalHandler::~TestSignalHandler() {
     delete mReadyToEmitEvent;
     delete mPlayStateChangedEvent;
     delete mFifoPositionChangedEvent;
+    delete mFifoLevelChangedEvent;
     delete mMuteChangedEvent;
     delete mVolumeChangedEvent;
     delete mOwnershipLostEvent;
@@ -100,6 +104,17 @@ void TestSignalHandler::RegisterHandlers() {
     ASSERT_EQ(status, ER_OK);
     mMatches.push_back("type='signal',interface='org.alljoyn.Stream.Port.AudioSink',member='FifoPositionChanged'");
 
+    const InterfaceDescription* flowControlIntf = mBus->GetInterface(AUDIO_SINK_FLOW_CONTROL_INTERFACE);
+    ASSERT_TRUE(flowControlIntf);
+
+    const InterfaceDescription::Member* fifoLevelChangedMember = flowControlIntf->GetMember("FifoLevelChanged");
+    ASSERT_TRUE(fifoLevelChangedMember);
+    status = mBus->RegisterSignalHandler(this,
+                                         static_cast<MessageReceiver::SignalHandler>(&TestSignalHandler::FifoLevelChangedSignalHandler),
+                                         fifoLevelChangedMember, mPortPath);
+    ASSERT_EQ(status, ER_OK);
+    mMatches.push_back("type='signal',interface='org.alljoyn.Stream.Port.AudioSink.FlowControl',member='FifoLevelChanged'");
+
     const InterfaceDescription::Member* playStateChangedMember = sinkIntf->GetMember("PlayStateChanged");
     ASSERT_TRUE(playStateChangedMember);
     status = mBus->RegisterSignalHandler(this,
@@ -171,6 +186,19 @@ void TestSignalHandler::FifoPositionChangedSignalHandler(const InterfaceDescript
     mFifoPositionChangedEvent->SetEvent();
 }
 
+void TestSignalHandler::FifoLevelChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg) {
+    CriticalSection lock;
+    size_t numArgs = 0;
+    const MsgArg* args = NULL;
+    msg->GetArgs(numArgs, args);
+    ASSERT_TRUE(numArgs == 2);
+
+    args[0].Get("u", &mFifoPosition);
+    args[1].Get("u", &mFifoCredit);
+
+    mFifoLevelChangedEvent->SetEvent();
+}
+
 void TestSignalHandler::PlayStateChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg) {
 
     CriticalSection lock;
@@ -214,6 +242,12 @@ uint8_t TestSignalHandler::GetPlayState() {
     return mPlayState;
 }
 
+void TestSignalHandler::GetFifoLevel(uint32_t& position, uint32_t& credit) {
+    CriticalSection lock;
+    position = mFifoPosition;
+    credit = mFifoCredit;
+}
+
 bool TestSignalHandler::GetMute() {
     CriticalSection lock;
     return mMute;
@@ -259,6 +293,16 @@ QStatus TestSignalHandler::WaitForFifoPositionChanged(uint32_t waitMs) {
     return status;
 }
 
+QStatus TestSignalHandler::WaitForFifoLevelChanged(uint32_t waitMs) {
+
+    QStatus status = ER_OK;
+    if (!mFifoLevelChangedEvent->IsSet()) {
+        status = Event::Wait(*mFifoLevelChangedEvent, waitMs);
+    }
+    mFifoLevelChangedEvent->ResetEvent();
+    return status;
+}
+
 QStatus TestSignalHandler::WaitForOwnershipLost(uint32_t waitMs) {
 
     QStatus status = ER_OK;
@@ -31,6 +31,7 @@ class TestSignalHandler : public BusObject {
     Event* mReadyToEmitEvent;
     Event* mPlayStateChangedEvent;
     Event* mFifoPositionChangedEvent;
+    Event* mFifoLevelChangedEvent;
     Event* mMuteChangedEvent;
     Event* mVolumeChangedEvent;
     Event* mOwnershipLostEvent;
@@ -38,6 +39,8 @@ class TestSignalHandler : public BusObject {
     const InterfaceDescription::Member* mImageDataMember;
     const InterfaceDescription::Member* mMetaDataMember;
     uint8_t mPlayState;
+    uint32_t mFifoPosition;
+    uint32_t mFifoCredit;
     bool mMute;
     int16_t mVolume;
     String mNewOwner;
@@ -52,17 +55,20 @@ class TestSignalHandler : public BusObject {
     void ObjectRegistered();
     void ObjectUnregistered();
     void FifoPositionChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
+    void FifoLevelChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
     void PlayStateChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
     void MuteChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
     void VolumeChangedSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
     void OwnershipLostSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
     uint8_t GetPlayState();
+    void GetFifoLevel(uint32_t& position, uint32_t& credit);
     bool GetMute();
     int16_t GetVolume();
     const char* GetNewOwner();
     QStatus WaitUntilReadyToEmit(uint32_t waitMs);
     QStatus WaitForPlayStateChanged(uint32_t waitMs);
     QStatus WaitForFifoPositionChanged(uint32_t waitMs);
+    QStatus WaitForFifoLevelChanged(uint32_t waitMs);
     QStatus WaitForMuteChanged(uint32_t waitMs);
     QStatus WaitForVolumeChanged(uint32_t waitMs);
     QStatus WaitForOwnershipLost(uint32_t waitMs);
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include "SharedMutex.h"
+#include "WorkerPool.h"
+#include "gtest/gtest.h"
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <string>
+
+using namespace ajn::services;
+using namespace qcc;
+using namespace std;
+
+/* Records the order in which the test threads got the lock */
+struct LockLog {
+    SharedMutex* lock;
+    Mutex mutex;
+    string order;
+    LockLog(SharedMutex* sharedMutex) : lock(sharedMutex) { }
+
+    void Add(char c) {
+        mutex.Lock();
+        order += c;
+        mutex.Unlock();
+    }
+
+    string Get() {
+        mutex.Lock();
+        string s = order;
+        mutex.Unlock();
+        return s;
+    }
+};
+
+static ThreadReturn ReaderThread(void* arg) {
+    LockLog* log = reinterpret_cast<LockLog*>(arg);
+    log->lock->LockShared();
+    log->Add('r');
+    log->lock->UnlockShared();
+    return 0;
+}
+
+static ThreadReturn WriterThread(void* arg) {
+    LockLog* log = reinterpret_cast<LockLog*>(arg);
+    log->lock->Lock();
+    log->Add('w');
+    Thread::Sleep(50);
+    log->lock->Unlock();
+    return 0;
+}
+
+TEST(WorkerTest, SharedMutexReadersShare) {
+    SharedMutex lock;
+    LockLog log(&lock);
+    lock.LockShared();
+    Thread reader("Reader", &ReaderThread);
+    reader.Start(&log);
+    reader.Join();
+    EXPECT_EQ("r", log.Get());
+    lock.UnlockShared();
+}
+
+TEST(WorkerTest, SharedMutexWriterExcludesReaders) {
+    SharedMutex lock;
+    LockLog log(&lock);
+    lock.Lock();
+    Thread reader("Reader", &ReaderThread);
+    reader.Start(&log);
+    Thread::Sleep(100);
+    EXPECT_EQ("", log.Get());
+    lock.Unlock();
+    reader.Join();
+    EXPECT_EQ("r", log.Get());
+}
+
+TEST(WorkerTest, SharedMutexWriterWaitsForReaders) {
+    SharedMutex lock;
+    LockLog log(&lock);
+    lock.LockShared();
+    Thread writer("Writer", &WriterThread);
+    writer.Start(&log);
+    Thread::Sleep(100);
+    EXPECT_EQ("", log.Get());
+    lock.UnlockShared();
+    writer.Join();
+    EXPECT_EQ("w", log.Get());
+}
+
+TEST(WorkerTest, SharedMutexPrefersWriters) {
+    SharedMutex lock;
+    LockLog log(&lock);
+    lock.LockShared();
+    Thread writer("Writer", &WriterThread);
+    writer.Start(&log);
+    Thread::Sleep(100);
+
+    /* A reader arriving while the writer waits goes after it */
+    Thread reader("Reader", &ReaderThread);
+    reader.Start(&log);
+    Thread::Sleep(100);
+    EXPECT_EQ("", log.Get());
+
+    /* The shared lock can still be taken again by a thread holding it */
+    lock.LockShared();
+    lock.UnlockShared();
+
+    lock.UnlockShared();
+    writer.Join();
+    reader.Join();
+    EXPECT_EQ("wr", log.Get());
+}
+
+TEST(WorkerTest, SharedMutexNests) {
+    SharedMutex lock;
+    LockLog log(&lock);
+    lock.Lock();
+    lock.Lock();
+    lock.LockShared();
+    lock.UnlockShared();
+    lock.Unlock();
+
+    /* Still held exclusively */
+    Thread reader("Reader", &ReaderThread);
+    reader.Start(&log);
+    Thread::Sleep(100);
+    EXPECT_EQ("", log.Get());
+    lock.Unlock();
+    reader.Join();
+    EXPECT_EQ("r", log.Get());
+}
+
+struct JobCounter {
+    WorkerPool* pool;
+    Mutex mutex;
+    size_t count;
+    JobCounter(WorkerPool* workerPool) : pool(workerPool), count(0) { }
+};
+
+static ThreadReturn CountJob(void* arg) {
+    JobCounter* counter = reinterpret_cast<JobCounter*>(arg);
+    Thread::Sleep(10);
+    counter->mutex.Lock();
+    counter->count++;
+    counter->mutex.Unlock();
+    return 0;
+}
+
+static ThreadReturn QueueCountJob(void* arg) {
+    JobCounter* counter = reinterpret_cast<JobCounter*>(arg);
+    Thread::Sleep(10);
+    counter->pool->Execute(&CountJob, counter, counter);
+    return 0;
+}
+
+TEST(WorkerTest, WorkerPoolWaitsForOwnerJobs) {
+    WorkerPool pool("Test", 2);
+    JobCounter counter(&pool);
+    JobCounter other(&pool);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(ER_OK, pool.Execute(&CountJob, &counter, &counter));
+    }
+    ASSERT_EQ(ER_OK, pool.Execute(&CountJob, &other, &other));
+    pool.Wait(&counter);
+    EXPECT_EQ(10U, counter.count);
+    pool.Wait(&other);
+    EXPECT_EQ(1U, other.count);
+}
+
+TEST(WorkerTest, WorkerPoolWaitsForQueuedJobs) {
+    WorkerPool pool("Test", 2);
+    JobCounter counter(&pool);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(ER_OK, pool.Execute(&QueueCountJob, &counter, &counter));
+    }
+    pool.Wait(&counter);
+    EXPECT_EQ(4U, counter.count);
+}